@@ -1,2 +1,9 @@
 /Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc test/vert.vert -o build/Shaders/vert.spv
 /Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc test/frag.frag -o build/Shaders/frag.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc shaders/FrustumCull.comp -o build/Shaders/FrustumCull.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc shaders/HiZPyramid.comp -o build/Shaders/HiZPyramid.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc shaders/HiZCull.comp -o build/Shaders/HiZCull.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc shaders/MeshletCull.comp -o build/Shaders/MeshletCull.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc -DHI_Z shaders/MeshletCull.comp -o build/Shaders/MeshletCullHiZ.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc --target-spv=spv1.4 shaders/Meshlet.task -o build/Shaders/MeshletTask.spv
+/Users/eprager/VulkanSDK/1.3.268.1/macOS/bin/glslc --target-spv=spv1.4 shaders/Meshlet.mesh -o build/Shaders/MeshletMesh.spv
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "DescriptorBase.hpp"
+
+namespace EVK {
+
+/*
+ A large array of combined image samplers, indexed by the slots of a `BindlessTextureTable`; declare it in GLSL as an unsized `sampler2D` array and index it with `nonuniformEXT`.
+ The array is partially bound, updated after bind, and has a variable count, so it must be the set's highest binding. Only changed slots are rewritten, which is allowed while the set is in use. Requires `Devices::SupportsBindlessTextures`.
+ */
+template <uint32_t binding, VkShaderStageFlags stageFlags, uint32_t capacity>
+class BindlessTexturesDescriptor : public DescriptorBase<binding, stageFlags> {
+public:
+	using DescriptorBase = typename BindlessTexturesDescriptor::DescriptorBase;
+	static constexpr uint32_t bindingValue = binding;
+	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
+	static constexpr VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+	
+	BindlessTexturesDescriptor() = default;
+	
+	void Set(const std::shared_ptr<BindlessTextureTable> &value){
+		if(value && value->Capacity() > capacity){
+			std::cout << "Cannot bind bindless texture table; it has more slots than the descriptor.\n";
+			return;
+		}
+		table = value;
+		for(std::vector<VkDescriptorImageInfo> &flightWritten : written){
+			flightWritten.clear();
+		}
+		DescriptorBase::valid = false;
+	}
+	
+	static constexpr VkDescriptorSetLayoutBinding layoutBinding = {
+		.binding = binding,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = capacity,
+		.stageFlags = stageFlags,
+		.pImmutableSamplers = nullptr
+	};
+	
+	// writes every used slot
+	std::optional<VkWriteDescriptorSet> DescriptorWrite(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight) const override {
+		if(!table || table->Used() == 0){
+			return {};
+		}
+		imageInfos.resize(table->Used());
+		for(uint32_t i=0; i<table->Used(); ++i){
+			imageInfos[i] = ImageInfo(i);
+		}
+		return Write(dstSet, 0, table->Used());
+	}
+	
+	// only the slots that have changed since the last write to `flight`'s copy of the set, in runs of consecutive slots
+	bool DescriptorWrites(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight, std::vector<VkWriteDescriptorSet> &writes) const override {
+		if(!table){
+			return false;
+		}
+		const uint32_t used = table->Used();
+		std::vector<VkDescriptorImageInfo> &flightWritten = written[flight];
+		imageInfos.resize(used);
+		uint32_t runStart = 0;
+		bool inRun = false;
+		for(uint32_t i=0; i<=used; ++i){
+			bool changed = false;
+			if(i < used){
+				imageInfos[i] = ImageInfo(i);
+				changed = i >= flightWritten.size() || flightWritten[i].imageView != imageInfos[i].imageView || flightWritten[i].sampler != imageInfos[i].sampler;
+			}
+			if(changed && !inRun){
+				runStart = i;
+				inRun = true;
+			} else if(!changed && inRun){
+				writes.push_back(Write(dstSet, runStart, i - runStart));
+				inRun = false;
+			}
+		}
+		// the writes are made straight after this returns
+		flightWritten.assign(imageInfos.begin(), imageInfos.end());
+		return true;
+	}
+	
+	uint64_t HandleVersion() const override {
+		return table ? table->HandleVersion() : 0;
+	}
+	
+	static constexpr VkDescriptorPoolSize poolSize = {
+		.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = capacity * MAX_FRAMES_IN_FLIGHT
+	};
+	
+private:
+	std::shared_ptr<BindlessTextureTable> table {};
+	
+	// the image infos being written, and those last written to each flight's copy of the set
+	mutable std::vector<VkDescriptorImageInfo> imageInfos {};
+	mutable std::array<std::vector<VkDescriptorImageInfo>, MAX_FRAMES_IN_FLIGHT> written {};
+	
+	VkDescriptorImageInfo ImageInfo(uint32_t index) const {
+		const BindlessTextureTable::Slot &slot = table->Get(index);
+		return {
+			.sampler = slot.sampler->Handle(),
+			.imageView = slot.image->View(),
+			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+	}
+	
+	VkWriteDescriptorSet Write(const VkDescriptorSet &dstSet, uint32_t first, uint32_t count) const {
+		return {
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = dstSet,
+			.dstBinding = binding,
+			.dstArrayElement = first,
+			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.descriptorCount = count,
+			.pImageInfo = &imageInfos[first]
+		};
+	}
+};
+
+} // namespace EVK
@@ -10,6 +10,7 @@ public:
 	using DescriptorBase = typename CombinedImageSamplersDescriptor::DescriptorBase;
 	static constexpr uint32_t bindingValue = binding;
 	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
 	
 	CombinedImageSamplersDescriptor() = default;
 	
@@ -56,6 +57,16 @@ public:
 		};
 	}
 	
+	uint64_t HandleVersion() const override {
+		uint64_t ret = 0;
+		for(const Combo &combo : combos){
+			if(combo.image){
+				ret += combo.image->HandleVersion();
+			}
+		}
+		return ret;
+	}
+	
 	static constexpr VkDescriptorPoolSize poolSize = {
 		.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 		.descriptorCount = count * MAX_FRAMES_IN_FLIGHT
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Devices.hpp"
+
+namespace EVK {
+
+/*
+ Base for objects whose device memory may be moved by the `EVK::Defragmenter`.
+ An object makes an allocation movable by calling `SetRelocatable(...)` on it, which stores a pointer to the object in the allocation's user data.
+ */
+class Relocatable {
+public:
+	virtual ~Relocatable() = default;
+	
+	// Create a new handle bound to `dstAllocation` and record the copy of the contents of `srcAllocation` into it. Return false to leave this allocation where it is.
+	virtual bool CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation) = 0;
+	
+	// The copy recorded by `CmdRelocate` has completed and `srcAllocation` now refers to the new memory; swap in the new handle and destroy the old one
+	virtual void FinishRelocation(VmaAllocation srcAllocation) = 0;
+	
+	// Incremented every time the Vulkan handles of this object are replaced, so descriptors referencing it know to re-write themselves
+	[[nodiscard]] uint64_t HandleVersion() const { return handleVersion; }
+	
+	// Also increment `counter` whenever the handles are replaced, for as long as it exists, e.g. for a table of many objects that keeps one version for all of them (see `BindlessTextureTable`)
+	void AddHandleVersionCounter(const std::shared_ptr<uint64_t> &counter){
+		for(const std::weak_ptr<uint64_t> &existing : handleVersionCounters){
+			if(existing.lock() == counter){
+				return;
+			}
+		}
+		handleVersionCounters.push_back(counter);
+	}
+	
+protected:
+	void IncrementHandleVersion(){
+		++handleVersion;
+		std::erase_if(handleVersionCounters, [](const std::weak_ptr<uint64_t> &weak){
+			const std::shared_ptr<uint64_t> counter = weak.lock();
+			if(!counter){
+				return true;
+			}
+			++*counter;
+			return false;
+		});
+	}
+	
+	void SetRelocatable(VmaAllocator allocator, VmaAllocation allocation){
+		vmaSetAllocationUserData(allocator, allocation, static_cast<Relocatable *>(this));
+	}
+	// call before handing an allocation over for deferred destruction, as the object may no longer exist when the allocation is freed
+	void UnsetRelocatable(VmaAllocator allocator, VmaAllocation allocation){
+		vmaSetAllocationUserData(allocator, allocation, nullptr);
+	}
+	
+private:
+	uint64_t handleVersion = 0;
+	std::vector<std::weak_ptr<uint64_t>> handleVersionCounters {};
+};
+
+/*
+ Incrementally compacts evk-owned device memory using VMA's defragmentation API.
+ Call `Step()` once per frame, *between* frames (after `EVK::Interface::EndFrame` and before the next `EVK::Interface::BeginFrame`), as the handles of moved objects are replaced.
+ Only allocations registered with `Relocatable::SetRelocatable` are moved; everything else is left in place.
+ */
+class Defragmenter {
+public:
+	struct Budget {
+		VkDeviceSize maxBytesPerPass;
+		uint32_t maxAllocationsPerPass;
+		std::chrono::microseconds maxTimePerStep;
+	};
+	
+	Defragmenter(std::shared_ptr<Devices> _devices, const Budget &_budget);
+	~Defragmenter();
+	
+	Defragmenter(const Defragmenter &) = delete;
+	Defragmenter &operator=(const Defragmenter &) = delete;
+	
+	// Perform defragmentation passes until the heap is compacted or the time budget is spent. Returns true if any objects were moved.
+	bool Step();
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	Budget budget;
+	
+	VmaDefragmentationContext context = nullptr;
+	
+	void Finish();
+};
+
+} // namespace EVK
@@ -13,20 +13,51 @@ public:
 	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
 	
 	bool Valid() const {
-		return valid;
+		return valid && writtenHandleVersion == HandleVersion();
+	}
+	void SetValid(){
+		valid = true;
+		writtenHandleVersion = HandleVersion();
 	}
-	void SetValid(){ valid = true; }
 	
 //	static virtual constexpr VkDescriptorSetLayoutBinding layoutBinding = 0;
 	
 	virtual std::optional<VkWriteDescriptorSet> DescriptorWrite(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight) const = 0;
 	
+	// Appends the writes needed to bring `dstSet` up to date; by default the single `DescriptorWrite`. Returns false if the descriptor cannot be written yet.
+	virtual bool DescriptorWrites(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight, std::vector<VkWriteDescriptorSet> &writes) const {
+		const std::optional<VkWriteDescriptorSet> write = DescriptorWrite(dstSet, imageInfoBuffer, imageInfoBufferIndex, bufferInfoBuffer, bufferInfoBufferIndex, flight);
+		if(!write){
+			return false;
+		}
+		writes.push_back(write.value());
+		return true;
+	}
+	
 //	static virtual constexpr VkDescriptorPoolSize poolSize = 0;
 	
+	// whether the descriptor writes the same thing for every flight; if all of a set's descriptors are, only one copy of the set is allocated and updated
+//	static virtual constexpr bool flightInvariant = false;
+	
 	virtual std::optional<DynamicUBOInfo> GetUBODynamic() const { return {}; }
 	
+	// For descriptors that consume a dynamic offset number, the distance between the elements consecutive numbers select; by default a dynamic UBO's alignment
+	virtual std::optional<VkDeviceSize> DynamicStride() const {
+		if(const std::optional<DynamicUBOInfo> dynamic = GetUBODynamic(); dynamic.has_value()){
+			return dynamic->alignment;
+		}
+		return {};
+	}
+	
+	// The dynamic offset selecting `flight`'s copy of a `FlightReplication::PACKED` buffer; unlike `GetUBODynamic`, this consumes no dynamic offset number
+	virtual std::optional<uint32_t> FlightDynamicOffset(uint32_t flight) const { return {}; }
+	
+	// Sum of the handle versions of the referenced `EVK::Relocatable` objects; when this changes (e.g. after defragmentation) the descriptor needs re-writing
+	virtual uint64_t HandleVersion() const { return 0; }
+	
 protected:
 	bool valid = false;
+	uint64_t writtenHandleVersion = 0;
 };
 
 } // namespace EVK
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "ShaderProgram.hpp"
+
+namespace EVK {
+
+/*
+ Allocates any number of instances of one descriptor set layout, e.g. one per material, so each is written once and then bound per draw with a pipeline's `CmdBindDescriptorSetInstance`, rather than re-setting and re-writing the pipeline's own set between draws.
+ `descriptorSet_t` is typically a pipeline's `uniforms_t::descriptorSet_t<set>`; any set type whose layout is identically defined to the pipeline's at that index can be bound.
+ Sets are allocated from pools of `setsPerPool` sets each, and another pool is created whenever they are all full.
+ Persistent instances (`New`) live until `Remove`d. Transient instances (`NewTransient`) are allocated from pools that are reset once their frame has finished, so are only valid for the frame in which they were made, and only for the flight they were made for.
+ If `Devices` uses descriptor buffers and the set can live in one, each instance instead has a region of `Devices`' descriptor buffer, from which it is bound with pipelines that use descriptor buffers. Its descriptor sets are then only allocated if it is bound with a pipeline that doesn't.
+ */
+template <typename descriptorSet_t_>
+class DescriptorSetAllocator {
+public:
+	using descriptorSet_t = descriptorSet_t_;
+	
+	static_assert(!descriptorSet_t::pushDescriptor, "Push descriptor sets are never allocated.");
+	
+	static constexpr int flightCopies = descriptorSet_t::flightCopies;
+	
+	using InstanceID = uint32_t;
+	
+	explicit DescriptorSetAllocator(std::shared_ptr<Devices> _devices, uint32_t _setsPerPool=64)
+	: devices(_devices), setsPerPool(_setsPerPool), prototype(_devices) {
+		if(setsPerPool == 0){
+			throw std::runtime_error("Descriptor set allocator pool size cannot be zero.");
+		}
+		layout = prototype.CachedLayout();
+		// the update templates only depend on the layout, so every instance shares the prototype's
+		prototype.CreateUpdateTemplates(layout);
+		
+		// as do the bindings' offsets in the descriptor buffer; each copy of a set there is aligned for binding
+		if constexpr (descriptorSet_t::descriptorBufferCompatible){
+			descriptorBuffers = _devices->UsesDescriptorBuffers();
+			if(descriptorBuffers){
+				const VkDeviceSize alignment = _devices->DescriptorBufferProperties().descriptorBufferOffsetAlignment;
+				descriptorBufferStride = (prototype.InitDescriptorBuffer(prototype.CachedLayout(true)) + alignment - 1) / alignment * alignment;
+			}
+		}
+	}
+	~DescriptorSetAllocator(){
+		prototype.DestroyUpdateTemplates();
+		for(const auto &[id, instance] : instances){
+			if(instance.region){
+				devices->FreeDescriptorBufferRegion(instance.region.value());
+			}
+		}
+		// frames in flight may still be reading sets from the pools
+		std::vector<VkDescriptorPool> allPools = pools;
+		for(const std::vector<VkDescriptorPool> &flightPools : transientPools){
+			allPools.insert(allPools.end(), flightPools.begin(), flightPools.end());
+		}
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), allPools = std::move(allPools)](){
+			for(VkDescriptorPool pool : allPools){
+				vkDestroyDescriptorPool(device, pool, nullptr);
+			}
+		});
+	}
+	
+	DescriptorSetAllocator(const DescriptorSetAllocator &) = delete;
+	DescriptorSetAllocator &operator=(const DescriptorSetAllocator &) = delete;
+	
+	// A new instance with no descriptors set, with a copy of the set for each flight unless the set is flight-invariant
+	[[nodiscard]]
+	InstanceID New(){
+		ReleasePendingFrees();
+		
+		Instance instance = NewInstance();
+		if(descriptorBuffers){
+			AllocateRegion(instance, flightCopies);
+		} else {
+			AllocateSets(instance);
+		}
+		return Emplace(std::move(instance));
+	}
+	
+	// A new instance, with a single set for `flight`, that is freed once the current frame has finished
+	[[nodiscard]]
+	InstanceID NewTransient(uint32_t flight){
+		static_assert(!descriptorSet_t::hasBindingFlags, "Descriptors with binding flags only write what has changed, so cannot be written to transient sets.");
+		
+		ResetTransientPools(flight);
+		
+		Instance instance = NewInstance();
+		instance.transient = true;
+		instance.flight = flight;
+		if(descriptorBuffers){
+			AllocateRegion(instance, 1);
+		} else {
+			AllocateTransientSet(instance);
+		}
+		return Emplace(std::move(instance));
+	}
+	
+	// The instance's sets, or its region of the descriptor buffer, are freed once every frame that may be using them has finished
+	void Remove(InstanceID id){
+		const auto it = instances.find(id);
+		if(it == instances.end()){
+			std::cout << "Cannot remove descriptor set instance; no such instance.\n";
+			return;
+		}
+		const Instance &instance = it->second;
+		if(!instance.transient && instance.pool != VK_NULL_HANDLE){
+			pendingFrees.push_back({devices->FrameTimeline(), instance.pool, instance.sets});
+		}
+		if(instance.region){
+			devices->FreeDescriptorBufferRegion(instance.region.value());
+		}
+		instances.erase(it);
+	}
+	
+	// Set the instance's descriptors through this, e.g. `Get(id).template iDescriptor<0>().Set(...)`
+	[[nodiscard]] descriptorSet_t &Get(InstanceID id){ return instances.at(id).descriptorSet; }
+	
+	[[nodiscard]] bool Contains(InstanceID id) const { return instances.contains(id); }
+	[[nodiscard]] size_t InstanceCount() const { return instances.size(); }
+	[[nodiscard]] VkDescriptorSetLayout Layout() const { return layout; }
+	
+	// Writes the instance's changed descriptors to `flight`'s copy of its set, or to its copy in the descriptor buffer if `descriptorBuffer`. Returns false if any cannot be written yet.
+	[[nodiscard]]
+	bool Update(InstanceID id, uint32_t flight, bool descriptorBuffer=false){
+		Instance &instance = instances.at(id);
+		if(instance.transient && instance.flight != flight){
+			std::cout << "Cannot update transient descriptor set instance; it was made for a different flight.\n";
+			return false;
+		}
+		if(descriptorBuffer && !instance.region){
+			std::cout << "Cannot update descriptor set instance; it has no descriptor buffer region.\n";
+			return false;
+		}
+		if(instance.descriptorSet.CheckDescriptorsValid(flight, descriptorBuffer)){
+			return true;
+		}
+		const uint32_t copy = descriptorSet_t::flightInvariant ? 0 : flight;
+		if(descriptorBuffer){
+			return instance.descriptorSet.Update(flight, VK_NULL_HANDLE, devices->DescriptorBufferData(instance.descriptorBufferOffsets[copy]));
+		}
+		// instances in the descriptor buffer only get sets once bound with a pipeline that doesn't use it
+		if(instance.pool == VK_NULL_HANDLE){
+			if(instance.transient){
+				AllocateTransientSet(instance);
+			} else {
+				AllocateSets(instance);
+			}
+		}
+		return instance.descriptorSet.Update(flight, instance.sets[copy]);
+	}
+	
+	// Updates and binds `flight`'s copy of the instance's set at index `set` of `pipelineLayout`; see the pipelines' `CmdBindDescriptorSetInstance`, which check the layouts are compatible. If `descriptorBuffer`, the pipeline uses descriptor buffers, so the instance is bound from its copy in the descriptor buffer, which must already be bound (see `Devices::CmdBindDescriptorBuffer`).
+	template <typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBind(InstanceID id, VkCommandBuffer commandBuffer, uint32_t flight, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, bool descriptorBuffer, const numbers_t &dynamicOffsetNumbers=numbers_t()){
+		if(!instances.contains(id)){
+			std::cout << "Cannot bind descriptor set instance; no such instance.\n";
+			return false;
+		}
+		if(!DynamicOffsetNumbersMatch<descriptorSet_t::dynamicOffsetNumberCount>(dynamicOffsetNumbers)){
+			return false;
+		}
+		if(!Update(id, flight, descriptorBuffer)){
+			return false;
+		}
+		const Instance &instance = instances.at(id);
+		if(descriptorBuffer){
+			// sets in descriptor buffers have no dynamic offsets
+			const uint32_t bufferIndex = 0;
+			const VkDeviceSize offset = instance.descriptorBufferOffsets[descriptorSet_t::flightInvariant ? 0 : flight];
+			devices->CmdSetDescriptorBufferOffsets(commandBuffer, bindPoint, pipelineLayout, set, 1, &bufferIndex, &offset);
+			return true;
+		}
+		std::array<uint32_t, descriptorSet_t::dynamicOffsetCount> dynamicOffsets {};
+		int indexOfDynamic = 0;
+		uint32_t *next = dynamicOffsets.data();
+		instance.descriptorSet.WriteDynamicOffsets(flight, dynamicOffsetNumbers, indexOfDynamic, next);
+		assert(indexOfDynamic == int(std::size(dynamicOffsetNumbers)));
+		const VkDescriptorSet handle = instance.sets[descriptorSet_t::flightInvariant ? 0 : flight];
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, set, 1, &handle, uint32_t(dynamicOffsets.size()), dynamicOffsets.empty() ? nullptr : dynamicOffsets.data());
+		return true;
+	}
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t setsPerPool;
+	
+	// owns the layout's update templates
+	descriptorSet_t prototype;
+	VkDescriptorSetLayout layout;
+	
+	// with descriptor buffers, an instance's copies of its set lie `descriptorBufferStride` apart in its region
+	bool descriptorBuffers = false;
+	VkDeviceSize descriptorBufferStride = 0;
+	
+	struct Instance {
+		descriptorSet_t descriptorSet;
+		// null until the sets are allocated
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		std::array<VkDescriptorSet, flightCopies> sets {};
+		std::optional<Devices::DescriptorBufferRegion> region {};
+		std::array<VkDeviceSize, flightCopies> descriptorBufferOffsets {};
+		bool transient = false;
+		uint32_t flight = 0;
+	};
+	std::unordered_map<InstanceID, Instance> instances {};
+	InstanceID nextID = 0;
+	
+	std::vector<VkDescriptorPool> pools {};
+	
+	struct PendingFree {
+		uint64_t frame;
+		VkDescriptorPool pool;
+		std::array<VkDescriptorSet, flightCopies> sets;
+	};
+	std::vector<PendingFree> pendingFrees {};
+	
+	// transient sets are allocated from the flight's pools in order, and the pools are reset rather than freeing sets
+	std::array<std::vector<VkDescriptorPool>, MAX_FRAMES_IN_FLIGHT> transientPools {};
+	std::array<size_t, MAX_FRAMES_IN_FLIGHT> transientPoolCursors {};
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> transientFrames {};
+	
+	Instance NewInstance() const {
+		Instance ret {
+			.descriptorSet = descriptorSet_t(devices)
+		};
+		ret.descriptorSet.ShareUpdateTemplates(prototype);
+		ret.descriptorSet.ShareDescriptorBufferOffsets(prototype);
+		return ret;
+	}
+	
+	void AllocateSets(Instance &instance){
+		for(size_t i=pools.size(); i-->0;){
+			if(Allocate(pools[i], flightCopies, instance.sets.data())){
+				instance.pool = pools[i];
+				return;
+			}
+		}
+		pools.push_back(CreatePool(true));
+		if(!Allocate(pools.back(), flightCopies, instance.sets.data())){
+			throw std::runtime_error("failed to allocate descriptor sets from new pool!");
+		}
+		instance.pool = pools.back();
+	}
+	
+	// A single set for the instance's flight, from that flight's transient pools
+	void AllocateTransientSet(Instance &instance){
+		std::vector<VkDescriptorPool> &flightPools = transientPools[instance.flight];
+		size_t &cursor = transientPoolCursors[instance.flight];
+		for(;; ++cursor){
+			const bool created = cursor == flightPools.size();
+			if(created){
+				flightPools.push_back(CreatePool(false));
+			}
+			if(Allocate(flightPools[cursor], 1, instance.sets.data())){
+				break;
+			}
+			if(created){
+				throw std::runtime_error("failed to allocate descriptor set from new pool!");
+			}
+		}
+		instance.sets.fill(instance.sets[0]);
+		instance.pool = flightPools[cursor];
+	}
+	
+	// `copies` copies of the set in the descriptor buffer; with fewer copies than flights, e.g. for transient instances, every flight uses the first
+	void AllocateRegion(Instance &instance, uint32_t copies) const {
+		instance.region = devices->AllocateDescriptorBufferRegion(copies * descriptorBufferStride);
+		if(!instance.region){
+			throw std::runtime_error("failed to allocate descriptor buffer region!");
+		}
+		for(uint32_t i=0; i<uint32_t(flightCopies); ++i){
+			instance.descriptorBufferOffsets[i] = instance.region->offset + (i < copies ? i : 0) * descriptorBufferStride;
+		}
+	}
+	
+	InstanceID Emplace(Instance &&instance){
+		const InstanceID id = nextID++;
+		instances.emplace(id, std::move(instance));
+		return id;
+	}
+	
+	VkDescriptorPool CreatePool(bool freeable) const {
+		std::array<VkDescriptorPoolSize, descriptorSet_t::descriptorCount> poolSizes = descriptorSet_t::setPoolSizes;
+		for(VkDescriptorPoolSize &poolSize : poolSizes){
+			poolSize.descriptorCount *= setsPerPool;
+		}
+		const VkDescriptorPoolCreateInfo poolInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = (freeable ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : VkDescriptorPoolCreateFlags(0)) | (descriptorSet_t::updateAfterBind ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : VkDescriptorPoolCreateFlags(0)),
+			.poolSizeCount = descriptorSet_t::descriptorCount,
+			.pPoolSizes = poolSizes.data(),
+			.maxSets = setsPerPool
+		};
+		VkDescriptorPool ret;
+		if(vkCreateDescriptorPool(devices->GetLogicalDevice(), &poolInfo, nullptr, &ret) != VK_SUCCESS){
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+		return ret;
+	}
+	
+	// Returns false if the pool is full
+	bool Allocate(VkDescriptorPool pool, uint32_t count, VkDescriptorSet *sets) const {
+		std::array<VkDescriptorSetLayout, flightCopies> layouts;
+		std::array<uint32_t, flightCopies> variableCounts;
+		layouts.fill(layout);
+		variableCounts.fill(descriptorSet_t::variableDescriptorCount);
+		// variable-count bindings are allocated at their full capacity
+		const VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+			.descriptorSetCount = count,
+			.pDescriptorCounts = variableCounts.data()
+		};
+		const VkDescriptorSetAllocateInfo allocInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = descriptorSet_t::variableDescriptorCount > 0 ? &variableCountInfo : nullptr,
+			.descriptorPool = pool,
+			.descriptorSetCount = count,
+			.pSetLayouts = layouts.data()
+		};
+		const VkResult result = vkAllocateDescriptorSets(devices->GetLogicalDevice(), &allocInfo, sets);
+		if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL){
+			return false;
+		}
+		if(result != VK_SUCCESS){
+			throw std::runtime_error("failed to allocate descriptor sets!");
+		}
+		return true;
+	}
+	
+	void ReleasePendingFrees(){
+		// frames up to `FrameTimeline() - MAX_FRAMES_IN_FLIGHT` have finished executing (see `EVK::Interface::BeginFrame`)
+		const uint64_t timeline = devices->FrameTimeline();
+		std::erase_if(pendingFrees, [&](const PendingFree &pending){
+			if(pending.frame + MAX_FRAMES_IN_FLIGHT > timeline){
+				return false;
+			}
+			vkFreeDescriptorSets(devices->GetLogicalDevice(), pending.pool, uint32_t(pending.sets.size()), pending.sets.data());
+			return true;
+		});
+	}
+	
+	// Once the frame that last allocated from `flight`'s transient pools has finished, its sets are all freed at once
+	void ResetTransientPools(uint32_t flight){
+		const uint64_t timeline = devices->FrameTimeline();
+		if(transientFrames[flight] == timeline){
+			return;
+		}
+		if(transientFrames[flight] + MAX_FRAMES_IN_FLIGHT <= timeline){
+			for(VkDescriptorPool pool : transientPools[flight]){
+				vkResetDescriptorPool(devices->GetLogicalDevice(), pool, 0);
+			}
+			transientPoolCursors[flight] = 0;
+			std::erase_if(instances, [&](const auto &entry){
+				if(!entry.second.transient || entry.second.flight != flight){
+					return false;
+				}
+				if(entry.second.region){
+					devices->FreeDescriptorBufferRegion(entry.second.region.value());
+				}
+				return true;
+			});
+		}
+		transientFrames[flight] = timeline;
+	}
+};
+
+} // namespace EVK
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <functional>
+#include <span>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
 
 #include "Header.hpp"
 
@@ -15,7 +19,8 @@ struct CommandEnvironment {
 
 class Devices {
 public:
-	Devices(const char *applicationName, std::vector<const char *> requiredExtensions, std::function<VkSurfaceKHR (VkInstance)> surfaceCreationFunction, const std::function<VkExtent2D ()> &_getExtentFunction, VkPhysicalDeviceFeatures gpuFeatures = {});
+	// If `useDescriptorBuffers` and VK_EXT_descriptor_buffer is available, uniforms keep their descriptors in regions of one descriptor buffer rather than in descriptor sets (see `UsesDescriptorBuffers` and `AllocateDescriptorBufferRegion`)
+	Devices(const char *applicationName, std::vector<const char *> requiredExtensions, std::function<VkSurfaceKHR (VkInstance)> surfaceCreationFunction, const std::function<VkExtent2D ()> &_getExtentFunction, VkPhysicalDeviceFeatures gpuFeatures = {}, bool useDescriptorBuffers = false);
 	
 	Devices() = delete;
 	Devices(const Devices &) = delete;
@@ -30,6 +35,18 @@ public:
 		void *ptr;
 		VkDeviceSize size;
 	};
+	// writes data directly into the given mapped upload memory
+	using MemoryWriter = std::function<void(std::span<std::byte>)>;
+	// a writer that copies in `memory` back to back; `memory` must outlive the writer
+	static MemoryWriter DeviceMemoriesWriter(const std::vector<DeviceMemory> &memory){
+		return [&memory](std::span<std::byte> dst){
+			VkDeviceSize offset = 0;
+			for(const DeviceMemory &dm : memory){
+				memcpy(dst.data() + offset, dm.ptr, (size_t)dm.size);
+				offset += dm.size;
+			}
+		};
+	}
 	
 	// Tools
 	// -----
@@ -39,19 +56,48 @@ public:
 	SwapChainSupportDetails QuerySwapChainSupport() const;
 	VkCommandBuffer BeginSingleTimeCommands() const;
 	void EndSingleTimeCommands(VkCommandBuffer commandBuffer) const;
-	void FillExistingDeviceLocalBuffer(VkBuffer bufferHandle, const std::vector<DeviceMemory> &memory) const;
+	// writes in place if the buffer's memory is host visible, otherwise through a staging buffer
+	void FillExistingDeviceLocalBuffer(VkBuffer bufferHandle, VmaAllocation allocation, const std::vector<DeviceMemory> &memory) const;
+	void FillExistingDeviceLocalBuffer(VkBuffer bufferHandle, VmaAllocation allocation, VkDeviceSize size, const MemoryWriter &writer, VkDeviceSize dstOffset=0) const;
 	void GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) const;
-	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const;
+	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset=0, VkDeviceSize dstOffset=0) const;
 	void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subResourceRange) const;
+	void CmdTransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subResourceRange) const;
 	void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t depth=1) const;
+	// creates a buffer bound to `dstAllocation` and records a copy of `srcBuffer` into it; returns `VK_NULL_HANDLE` on failure
+	VkBuffer CmdRelocateBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkDeviceSize size, VkBufferUsageFlags usage, VmaAllocation dstAllocation) const;
+	
+	// Deferred destruction
+	// -----
+	// `destroy` is called once every frame that may be using the object being destroyed has finished executing (or when `Devices` is destroyed)
+	void EnqueueDestruction(std::function<void()> destroy){
+		pendingDestructions.push_back({frameTimeline, std::move(destroy)});
+	}
+	// Called by `EVK::Interface`; frame `frameTimeline` is the frame currently being recorded
+	void AdvanceFrameTimeline(){ ++frameTimeline; }
+	// Called by `EVK::Interface` once frame `completedFrame` is known to have finished executing
+	void ExecuteDestructions(uint64_t completedFrame);
+	[[nodiscard]] uint64_t FrameTimeline() const { return frameTimeline; }
 	
 	// Builders
 	// -----
 	VkShaderModule CreateShaderModule(const char *filename) const;
-	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo *allocationInfoDst=nullptr) const;
-	void CreateImage(const VkImageCreateInfo &imageCI, VkMemoryPropertyFlags properties, VkImage &image, VmaAllocation &allocation) const;
+	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo *allocationInfoDst=nullptr, VkMemoryPropertyFlags preferredProperties=0) const;
+	// Creates a buffer in device local memory, which is also mapped if possible (see `HasHostVisibleDeviceLocalMemory`). Returns true if the buffer can be written through `allocationInfo.pMappedData`.
+	bool CreateDeviceLocalBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo &allocationInfo) const;
+	// Creates a buffer backed directly by the host memory at `hostPointer` (e.g. an mmap'd file region), without copying it. `hostPointer` and `size` must be multiples of `HostImportAlignment()`, and the memory must remain valid until the buffer is destroyed. Returns false if the memory could not be imported.
+	bool ImportHostBuffer(void *hostPointer, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory) const;
+	void CreateImage(const VkImageCreateInfo &imageCI, VkMemoryPropertyFlags properties, VkImage &image, VmaAllocation &allocation, bool dedicated=true) const;
 	VkImageView CreateImageView(const VkImageViewCreateInfo &imageViewCI) const;
 	void CreateAndFillDeviceLocalBuffer(VkBuffer &bufferHandle, VmaAllocation &allocation, const std::vector<DeviceMemory> &memory, const VkBufferUsageFlags &usageFlags) const;
+	void CreateAndFillDeviceLocalBuffer(VkBuffer &bufferHandle, VmaAllocation &allocation, VkDeviceSize size, const MemoryWriter &writer, const VkBufferUsageFlags &usageFlags) const;
+	
+	// Layout cache
+	// -----
+	// Identical layouts are created once and then shared, so are the same handles. The cache owns them until `Devices` is destroyed.
+	// `hash` identifies the layout's contents, e.g. `DescriptorSetImpl::layoutHash`; layouts with equal hashes are still compared in full
+	VkDescriptorSetLayout CachedDescriptorSetLayout(uint64_t hash, const VkDescriptorSetLayoutCreateInfo &createInfo);
+	VkPipelineLayout CachedPipelineLayout(const VkPipelineLayoutCreateInfo &createInfo);
 	
 	// Getters
 	// -----
@@ -61,6 +107,100 @@ public:
 		return ret;
 	}
 	const VkPhysicalDeviceProperties &GetPhysicalDeviceProperties() const { return physicalDeviceProperties; }
+	// e.g. integrated GPUs, discrete GPUs with resizable BAR, software rasterisers
+	bool HasHostVisibleDeviceLocalMemory() const { return hostVisibleDeviceLocalMemory; }
+	// the features the logical device was created with
+	const VkPhysicalDeviceFeatures &GetFeatures() const { return features; }
+	const VkPhysicalDeviceVulkan12Features &GetVulkan12Features() const { return features12; }
+	// whether indirect draws may have a nonzero `firstInstance`, as the GPU cullers' do (see `FrustumCuller`)
+	bool SupportsDrawIndirectFirstInstance() const { return features.drawIndirectFirstInstance; }
+	// whether the descriptor indexing features used by `BindlessTexturesDescriptor` are enabled
+	bool SupportsBindlessTextures() const { return features12.descriptorBindingPartiallyBound && features12.descriptorBindingSampledImageUpdateAfterBind && features12.descriptorBindingVariableDescriptorCount; }
+	// whether VK_EXT_external_memory_host is available (see `ImportHostBuffer`)
+	bool SupportsHostMemoryImport() const { return hostImportAlignment != 0; }
+	VkDeviceSize HostImportAlignment() const { return hostImportAlignment; }
+	// whether VK_KHR_push_descriptor is available (see `PushedUniform`), and how many descriptors a push descriptor set may hold
+	bool SupportsPushDescriptors() const { return maxPushDescriptors != 0; }
+	uint32_t MaxPushDescriptors() const { return maxPushDescriptors; }
+	void CmdPushDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set, uint32_t writeCount, const VkWriteDescriptorSet *writes) const {
+		cmdPushDescriptorSet(commandBuffer, bindPoint, layout, set, writeCount, writes);
+	}
+	// whether buffers can be created with `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT` (see `BufferDeviceAddress`)
+	bool SupportsBufferDeviceAddress() const { return features12.bufferDeviceAddress; }
+	// whether VK_EXT_descriptor_buffer was requested and is available
+	bool UsesDescriptorBuffers() const { return descriptorBufferFeatures.descriptorBuffer; }
+	const VkPhysicalDeviceDescriptorBufferPropertiesEXT &DescriptorBufferProperties() const { return descriptorBufferProperties; }
+	// the size of one descriptor of `type` in a descriptor buffer
+	size_t DescriptorSize(VkDescriptorType type) const;
+	VkDeviceSize DescriptorSetLayoutSize(VkDescriptorSetLayout layout) const {
+		VkDeviceSize ret;
+		getDescriptorSetLayoutSize(logicalDevice, layout, &ret);
+		return ret;
+	}
+	VkDeviceSize DescriptorSetLayoutBindingOffset(VkDescriptorSetLayout layout, uint32_t binding) const {
+		VkDeviceSize ret;
+		getDescriptorSetLayoutBindingOffset(logicalDevice, layout, binding, &ret);
+		return ret;
+	}
+	void GetDescriptor(const VkDescriptorGetInfoEXT &getInfo, size_t size, void *dst) const {
+		getDescriptor(logicalDevice, &getInfo, size, dst);
+	}
+	// Every set's descriptors live in a region of one descriptor buffer owned here, so it is bound once per command buffer and binding a set only points it at its region (see `CmdSetDescriptorBufferOffsets`)
+	struct DescriptorBufferRegion {
+		VmaVirtualAllocation allocation;
+		VkDeviceSize offset;
+	};
+	// A region of `size` bytes, aligned for a set to be bound at. Returns no value if the descriptor buffer is full.
+	std::optional<DescriptorBufferRegion> AllocateDescriptorBufferRegion(VkDeviceSize size);
+	// The region is reused once every frame that may be reading it has finished
+	void FreeDescriptorBufferRegion(const DescriptorBufferRegion &region);
+	// where to write the descriptors at `offset` in the descriptor buffer
+	std::byte *DescriptorBufferData(VkDeviceSize offset) const { return descriptorBufferData + offset; }
+	// Binds the descriptor buffer as buffer index 0. `EVK::Interface` does this for the command buffers it begins; other command buffers that bind sets of pipelines using descriptor buffers need it once too.
+	void CmdBindDescriptorBuffer(VkCommandBuffer commandBuffer) const {
+		const VkDescriptorBufferBindingInfoEXT bindingInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+			.address = descriptorBufferAddress,
+			.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+		};
+		cmdBindDescriptorBuffers(commandBuffer, 1, &bindingInfo);
+	}
+	void CmdSetDescriptorBufferOffsets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount, const uint32_t *bufferIndices, const VkDeviceSize *offsets) const {
+		cmdSetDescriptorBufferOffsets(commandBuffer, bindPoint, layout, firstSet, setCount, bufferIndices, offsets);
+	}
+	// `buffer` must have been created with `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT`
+	VkDeviceAddress BufferDeviceAddress(VkBuffer buffer) const {
+		const VkBufferDeviceAddressInfo addressInfo{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+			.buffer = buffer
+		};
+		return vkGetBufferDeviceAddress(logicalDevice, &addressInfo);
+	}
+	// whether VK_EXT_conditional_rendering is available (see `CmdBeginConditionalRendering`)
+	bool SupportsConditionalRendering() const { return conditionalRenderingFeatures.conditionalRendering; }
+	// Subsequent draws and dispatches are discarded if the `uint32_t` at `offset` in `buffer` is zero. `buffer` needs `VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT`.
+	void CmdBeginConditionalRendering(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, bool inverted=false) const {
+		const VkConditionalRenderingBeginInfoEXT beginInfo{
+			.sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT,
+			.buffer = buffer,
+			.offset = offset,
+			.flags = inverted ? VkConditionalRenderingFlagsEXT(VK_CONDITIONAL_RENDERING_INVERTED_BIT_EXT) : 0
+		};
+		cmdBeginConditionalRendering(commandBuffer, &beginInfo);
+	}
+	void CmdEndConditionalRendering(VkCommandBuffer commandBuffer) const {
+		cmdEndConditionalRendering(commandBuffer);
+	}
+	// whether VK_EXT_mesh_shader is available, and with task shaders (see `MeshPipeline`)
+	bool SupportsMeshShaders() const { return meshShaderFeatures.meshShader; }
+	bool SupportsTaskShaders() const { return meshShaderFeatures.taskShader; }
+	void CmdDrawMeshTasks(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const {
+		cmdDrawMeshTasks(commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+	// `buffer` holds `drawCount` `VkDrawMeshTasksIndirectCommandEXT`s
+	void CmdDrawMeshTasksIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount) const {
+		cmdDrawMeshTasksIndirect(commandBuffer, buffer, offset, drawCount, sizeof(VkDrawMeshTasksIndirectCommandEXT));
+	}
 #ifdef MSAA
 	const VkSampleCountFlagBits &GetMSAASamples() const { return msaaSamples; }
 #endif
@@ -84,6 +224,56 @@ private:
 	VkSurfaceKHR surface;
 	VkPhysicalDevice physicalDevice;
 	VkPhysicalDeviceProperties physicalDeviceProperties;
+	VkPhysicalDeviceFeatures features;
+	// optional core 1.2 features are enabled here if supported
+	VkPhysicalDeviceVulkan12Features features12 {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+	};
+	bool hostVisibleDeviceLocalMemory = false;
+	VkDeviceSize hostImportAlignment = 0; // zero if VK_EXT_external_memory_host is unsupported
+	PFN_vkGetMemoryHostPointerPropertiesEXT getMemoryHostPointerProperties = nullptr;
+	uint32_t maxPushDescriptors = 0; // zero if VK_KHR_push_descriptor is unsupported
+	PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr;
+	VkPhysicalDeviceConditionalRenderingFeaturesEXT conditionalRenderingFeatures {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT
+	};
+	PFN_vkCmdBeginConditionalRenderingEXT cmdBeginConditionalRendering = nullptr;
+	PFN_vkCmdEndConditionalRenderingEXT cmdEndConditionalRendering = nullptr;
+	VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT
+	};
+	PFN_vkCmdDrawMeshTasksEXT cmdDrawMeshTasks = nullptr;
+	PFN_vkCmdDrawMeshTasksIndirectEXT cmdDrawMeshTasksIndirect = nullptr;
+	VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT
+	};
+	// enabled alongside descriptor buffers, which depend on it
+	VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR
+	};
+	VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT
+	};
+	PFN_vkGetDescriptorSetLayoutSizeEXT getDescriptorSetLayoutSize = nullptr;
+	PFN_vkGetDescriptorSetLayoutBindingOffsetEXT getDescriptorSetLayoutBindingOffset = nullptr;
+	PFN_vkGetDescriptorEXT getDescriptor = nullptr;
+	PFN_vkCmdBindDescriptorBuffersEXT cmdBindDescriptorBuffers = nullptr;
+	PFN_vkCmdSetDescriptorBufferOffsetsEXT cmdSetDescriptorBufferOffsets = nullptr;
+	// the descriptor buffer, sub-allocated through a VMA virtual block
+	static constexpr VkDeviceSize descriptorBufferCapacity = VkDeviceSize(1) << 22;
+	VkBuffer descriptorBuffer = VK_NULL_HANDLE;
+	VmaAllocation descriptorBufferAllocation = VK_NULL_HANDLE;
+	VmaVirtualBlock descriptorBufferBlock = VK_NULL_HANDLE;
+	std::byte *descriptorBufferData = nullptr;
+	VkDeviceAddress descriptorBufferAddress = 0;
+	
+	// descriptor buffers refer to uniform and storage buffers by address, so they must all be addressable
+	VkBufferUsageFlags AddressableUsage(VkBufferUsageFlags usage) const {
+		if(descriptorBufferFeatures.descriptorBuffer && (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))){
+			usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+		}
+		return usage;
+	}
 	QueueFamilyIndices queueFamilyIndices;
 	VkDevice logicalDevice;
 	VmaAllocator allocator;
@@ -93,6 +283,28 @@ private:
 	
 	std::function<VkExtent2D ()> getExtentFunction;
 	
+	struct PendingDestruction {
+		uint64_t frame;
+		std::function<void()> destroy;
+	};
+	std::deque<PendingDestruction> pendingDestructions {};
+	uint64_t frameTimeline = 0;
+	
+	// cached layouts, bucketed by hash
+	struct CachedDescriptorSetLayoutEntry {
+		VkDescriptorSetLayoutCreateFlags flags;
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+		VkDescriptorSetLayout handle;
+	};
+	std::unordered_map<uint64_t, std::vector<CachedDescriptorSetLayoutEntry>> descriptorSetLayoutCache {};
+	struct CachedPipelineLayoutEntry {
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		VkPipelineLayout handle;
+	};
+	std::unordered_map<uint64_t, std::vector<CachedPipelineLayoutEntry>> pipelineLayoutCache {};
+	
 	// queues:
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
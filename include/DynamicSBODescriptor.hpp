@@ -0,0 +1,81 @@
+#pragma once
+
+#include "DescriptorBase.hpp"
+
+namespace EVK {
+
+// A dynamic storage buffer descriptor that exposes one `T` of an SBO holding an array of them, each `StorageBufferObject::DynamicStride(sizeof(T))` apart; which one is chosen by a dynamic offset number when binding
+template <uint32_t binding, VkShaderStageFlags stageFlags, typename T>
+class DynamicSBODescriptor : public DescriptorBase<binding, stageFlags> {
+public:
+	using DescriptorBase = typename DynamicSBODescriptor::DescriptorBase;
+	static constexpr uint32_t bindingValue = binding;
+	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = false;
+	static constexpr bool consumesDynamicOffsetNumber = true;
+	
+	DynamicSBODescriptor() = default;
+	
+	void Set(const std::shared_ptr<StorageBufferObject> &value){
+		object = value;
+		DescriptorBase::valid = false;
+	}
+	
+	static constexpr VkDescriptorSetLayoutBinding layoutBinding = {
+		.binding = binding,
+		.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+		.descriptorCount = 1,
+		.stageFlags = stageFlags,
+		.pImmutableSamplers = nullptr
+	};
+	
+	std::optional<VkWriteDescriptorSet> DescriptorWrite(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight) const override {
+		if(!object){
+			return {};
+		}
+		
+		// the range covers a single element; the dynamic offset moves it
+		bufferInfoBuffer[bufferInfoBufferIndex].buffer = object->BufferFlying(flight);
+		bufferInfoBuffer[bufferInfoBufferIndex].offset = 0;
+		bufferInfoBuffer[bufferInfoBufferIndex].range = sizeof(T);
+		
+		return (VkWriteDescriptorSet){
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = dstSet,
+			.dstBinding = binding,
+			.dstArrayElement = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+			.descriptorCount = 1,
+			.pBufferInfo = &bufferInfoBuffer[bufferInfoBufferIndex++]
+		};
+	}
+	
+	uint64_t HandleVersion() const override {
+		return object ? object->HandleVersion() : 0;
+	}
+	
+	static constexpr VkDescriptorPoolSize poolSize = {
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+		.descriptorCount = 1 * MAX_FRAMES_IN_FLIGHT
+	};
+	
+	std::optional<VkDeviceSize> DynamicStride() const override {
+		if(!object){
+			return {};
+		}
+		return object->DynamicStride(sizeof(T));
+	}
+	
+	// a packed SBO's flights are also selected by the dynamic offset
+	std::optional<uint32_t> FlightDynamicOffset(uint32_t flight) const override {
+		if(!object || object->Replication() != FlightReplication::PACKED){
+			return {};
+		}
+		return uint32_t(flight * object->FlightStride());
+	}
+	
+private:
+	std::shared_ptr<StorageBufferObject> object {};
+};
+
+} // namespace EVK
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "Devices.hpp"
+
+namespace EVK {
+
+/*
+ Sub-allocates the vertices and indices of many meshes out of one large vertex buffer and one large index buffer, so every mesh in the pool is drawn after a single `CmdBind`.
+ All meshes in a pool share one vertex layout (`vertexStride`) and index type. Space is managed by VMA virtual blocks, measured in vertices and indices, so each mesh's offsets can be passed straight to `vkCmdDrawIndexed`.
+ `Compact` re-packs the live meshes to remove fragmentation; mesh IDs stay valid, but their offsets and the pool's buffers change.
+ */
+class GeometryPool {
+public:
+	GeometryPool(std::shared_ptr<Devices> _devices,
+				 uint32_t _vertexStride,
+				 uint32_t _vertexCapacity,
+				 uint32_t _indexCapacity,
+				 VkIndexType _indexType=VK_INDEX_TYPE_UINT32,
+				 VkBufferUsageFlags extraUsages=0);
+	~GeometryPool();
+	
+	GeometryPool(const GeometryPool &) = delete;
+	GeometryPool &operator=(const GeometryPool &) = delete;
+	
+	using MeshID = uint32_t;
+	
+	struct Mesh {
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t vertexCount;
+	};
+	
+	// `vertexWriter` and `indexWriter` are given the mapped memory to write the mesh's vertices and indices into directly. Compacts the pool if that makes room. Returns no value if the pool is full.
+	[[nodiscard]] std::optional<MeshID> Add(uint32_t vertexCount, const Devices::MemoryWriter &vertexWriter, uint32_t indexCount, const Devices::MemoryWriter &indexWriter);
+	[[nodiscard]] std::optional<MeshID> Add(const std::vector<Devices::DeviceMemory> &vertexMemory, const std::vector<Devices::DeviceMemory> &indexMemory);
+	
+	// The mesh's space is reused once every frame that may be drawing it has finished
+	void Remove(MeshID id);
+	
+	[[nodiscard]] const Mesh &GetMesh(MeshID id) const { return entries.at(id).mesh; }
+	
+	// Removes fragmentation by copying every live mesh to the start of new buffers
+	void Compact();
+	
+	void CmdBind(VkCommandBuffer commandBuffer, uint32_t binding=0) const {
+		const VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, binding, 1, &vertexBuffer, &offset);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+	}
+	
+	// The pool must be bound
+	void CmdDrawMesh(VkCommandBuffer commandBuffer, MeshID id, uint32_t instanceCount=1, uint32_t firstInstance=0) const {
+		const Mesh &mesh = GetMesh(id);
+		vkCmdDrawIndexed(commandBuffer, mesh.indexCount, instanceCount, mesh.firstIndex, mesh.vertexOffset, firstInstance);
+	}
+	
+	[[nodiscard]] VkBuffer VertexBuffer() const { return vertexBuffer; }
+	[[nodiscard]] VkBuffer IndexBuffer() const { return indexBuffer; }
+	[[nodiscard]] VkIndexType IndexType() const { return indexType; }
+	[[nodiscard]] uint32_t VertexStride() const { return vertexStride; }
+	[[nodiscard]] size_t MeshCount() const { return entries.size(); }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t vertexStride;
+	uint32_t vertexCapacity;
+	uint32_t indexCapacity;
+	VkIndexType indexType;
+	uint32_t indexSize;
+	VkBufferUsageFlags vertexUsage;
+	VkBufferUsageFlags indexUsage;
+	
+	VkBuffer vertexBuffer;
+	VmaAllocation vertexAllocation;
+	VmaVirtualBlock vertexBlock;
+	VkBuffer indexBuffer;
+	VmaAllocation indexAllocation;
+	VmaVirtualBlock indexBlock;
+	
+	struct Entry {
+		Mesh mesh;
+		VmaVirtualAllocation vertexRange;
+		VmaVirtualAllocation indexRange;
+	};
+	std::unordered_map<MeshID, Entry> entries {};
+	MeshID nextID = 0;
+	
+	struct PendingFree {
+		uint64_t frame;
+		VmaVirtualAllocation vertexRange;
+		VmaVirtualAllocation indexRange;
+	};
+	std::vector<PendingFree> pendingFrees {};
+	
+	void CreateBuffers();
+	void DestroyBuffers();
+	[[nodiscard]] bool Allocate(uint32_t vertexCount, uint32_t indexCount, Entry &entry);
+	void ReleasePendingFrees();
+};
+
+} // namespace EVK
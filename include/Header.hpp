@@ -87,6 +87,16 @@ template <typename T> T PositiveModulo(const T &lhs, const T &rhs){
 	return ((lhs % rhs) + rhs) % rhs;
 }
 
+// FNV-1a over the bytes of `value`, usable at compile time; start from `hashSeed`
+constexpr uint64_t hashSeed = 0xcbf29ce484222325;
+constexpr uint64_t HashCombine(uint64_t hash, uint64_t value){
+	for(int i=0; i<8; ++i){
+		hash ^= (value >> (8 * i)) & 0xff;
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
 struct SwapChainSupportDetails {
 	VkSurfaceCapabilitiesKHR capabilities;
 	std::vector<VkSurfaceFormatKHR> formats;
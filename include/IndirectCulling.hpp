@@ -0,0 +1,111 @@
+#pragma once
+
+#include "ShaderProgram.hpp"
+
+namespace EVK {
+
+// One object to cull, in std430 layout. `mesh` indexes the mesh table, whose entries have the layout of `GeometryPool::Mesh`.
+struct CullingInstance {
+	std::array<float, 4> boundingSphere; // centre xyz, radius w
+	uint32_t mesh;
+	uint32_t padding[3];
+};
+static_assert(sizeof(CullingInstance) == 32);
+
+struct FrustumCullPushConstants {
+	std::array<std::array<float, 4>, 6> planes; // xyz inward-facing normal, w distance; a point p is inside if dot(xyz, p) + w >= 0
+	uint32_t instanceCount;
+};
+
+/*
+ Frustum-culls instances on the GPU with a compute shader (see 'shaders/FrustumCull.comp'), which appends a `VkDrawIndexedIndirectCommand` for each visible instance and counts them.
+ Draw the result with `RenderPipeline::CmdDrawIndexedIndirectCount`, passing `DrawCommands()` and `DrawCount()`, with the meshes' `GeometryPool` bound. Each draw's `firstInstance` is the index of its instance, for looking up per-instance data.
+ `CmdCull` must be recorded outside a render pass, i.e. between `EVK::Interface::BeginFrame` and `EVK::Interface::BeginSwapChainRenderPass`.
+ Requires `Devices::SupportsDrawIndirectFirstInstance`.
+ */
+template <const char *filename>
+class FrustumCuller {
+public:
+	using shader_t = Shader<VK_SHADER_STAGE_COMPUTE_BIT, filename, PushConstants<0, FrustumCullPushConstants>,
+	SBOUniform<0, 0>, // instances
+	SBOUniform<0, 1>, // meshes
+	SBOUniform<0, 2>, // draw commands
+	SBOUniform<0, 3>  // draw count
+	>;
+	using pipeline_t = ComputePipeline<shader_t>;
+	
+	static constexpr uint32_t workGroupSize = 64;
+	
+	FrustumCuller(std::shared_ptr<Devices> _devices, uint32_t _maxInstances)
+	: devices(_devices),
+	maxInstances(_maxInstances),
+	pipeline(_devices),
+	drawCommands(std::make_shared<StorageBufferObject>(_devices, VkDeviceSize(_maxInstances) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)),
+	drawCount(std::make_shared<StorageBufferObject>(_devices, sizeof(uint32_t), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+		if(!devices->SupportsDrawIndirectFirstInstance()){
+			throw std::runtime_error("failed to create frustum culler; drawIndirectFirstInstance is not supported!");
+		}
+		pipeline.template iDescriptorSet<0>().template iDescriptor<2>().Set(drawCommands);
+		pipeline.template iDescriptorSet<0>().template iDescriptor<3>().Set(drawCount);
+	}
+	
+	// `instances` holds up to `maxInstances` `CullingInstance`s
+	void SetInstances(const std::shared_ptr<StorageBufferObject> &instances){
+		pipeline.template iDescriptorSet<0>().template iDescriptor<0>().Set(instances);
+	}
+	// `meshes` holds the `GeometryPool::Mesh`es that `CullingInstance::mesh` indexes
+	void SetMeshes(const std::shared_ptr<StorageBufferObject> &meshes){
+		pipeline.template iDescriptorSet<0>().template iDescriptor<1>().Set(meshes);
+	}
+	
+	[[nodiscard]]
+	bool CmdCull(const CommandEnvironment &commandEnvironment, const std::array<std::array<float, 4>, 6> &planes, uint32_t instanceCount){
+		if(instanceCount > maxInstances){
+			std::cout << "Cannot cull instances; there are more than the maximum.\n";
+			return false;
+		}
+		
+		// resetting this flight's count
+		vkCmdFillBuffer(commandEnvironment.commandBuffer, drawCount->BufferFlying(commandEnvironment.flight), commandEnvironment.flight * drawCount->FlightStride(), sizeof(uint32_t), 0);
+		const VkMemoryBarrier resetBarrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		};
+		vkCmdPipelineBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+		
+		pipeline.CmdBind(commandEnvironment.commandBuffer);
+		if(!pipeline.CmdBindDescriptorSets(commandEnvironment.commandBuffer, commandEnvironment.flight)){
+			return false;
+		}
+		FrustumCullPushConstants pushConstants{
+			.planes = planes,
+			.instanceCount = instanceCount
+		};
+		pipeline.template CmdPushConstants<0>(commandEnvironment.commandBuffer, &pushConstants);
+		vkCmdDispatch(commandEnvironment.commandBuffer, (instanceCount + workGroupSize - 1) / workGroupSize, 1, 1);
+		
+		// making the commands and count visible to indirect draws
+		const VkMemoryBarrier cullBarrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+		};
+		vkCmdPipelineBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+		return true;
+	}
+	
+	[[nodiscard]] const StorageBufferObject &DrawCommands() const { return *drawCommands; }
+	[[nodiscard]] const StorageBufferObject &DrawCount() const { return *drawCount; }
+	[[nodiscard]] uint32_t MaxInstances() const { return maxInstances; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t maxInstances;
+	pipeline_t pipeline;
+	std::shared_ptr<StorageBufferObject> drawCommands;
+	std::shared_ptr<StorageBufferObject> drawCount;
+};
+
+} // namespace EVK
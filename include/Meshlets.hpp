@@ -0,0 +1,168 @@
+#pragma once
+
+#include "IndirectCulling.hpp"
+
+namespace EVK {
+
+// One cluster of a mesh's triangles, in std430 layout
+struct Meshlet {
+	std::array<float, 4> boundingSphere; // centre xyz, radius w
+	std::array<float, 4> cone; // axis xyz; the meshlet faces away from a viewer at p if dot(centre - p, axis) >= w * |centre - p| + radius. w is 1 if the meshlet can never be backface culled.
+	uint32_t vertexOffset; // into `MeshletData::vertices`
+	uint32_t vertexCount;
+	uint32_t triangleOffset; // into `MeshletData::triangles` (in triangles), and `MeshletData::indices` (in triangles)
+	uint32_t triangleCount;
+};
+static_assert(sizeof(Meshlet) == 48);
+
+struct MeshletData {
+	std::vector<Meshlet> meshlets;
+	// the mesh's indices reordered so each meshlet's triangles are contiguous, for drawing meshlets as index ranges
+	std::vector<uint32_t> indices;
+	// each meshlet's vertices, as indices into the mesh's vertices
+	std::vector<uint32_t> vertices;
+	// each meshlet's triangles, as 3 indices into its own vertices
+	std::vector<uint8_t> triangles;
+};
+
+/*
+ Splits indexed triangles into meshlets of at most `maxVertices` vertices and `maxTriangles` triangles, in index order, and calculates their bounds.
+ The positions are 3 floats at `positionOffset` within each `vertexStride`-byte vertex. This does not use the device, so can be run offline with the results saved.
+ */
+MeshletData BuildMeshlets(const std::byte *vertices, uint32_t vertexCount, uint32_t vertexStride, uint32_t positionOffset, std::span<const uint32_t> indices, uint32_t maxVertices=64, uint32_t maxTriangles=124);
+
+// The meshlets' data in storage buffers, for culling and drawing on the GPU. The triangles are packed 4 bytes to a `uint`.
+struct MeshletBuffers {
+	std::shared_ptr<StorageBufferObject> meshlets;
+	std::shared_ptr<StorageBufferObject> vertices;
+	std::shared_ptr<StorageBufferObject> triangles;
+	uint32_t meshletCount;
+};
+MeshletBuffers UploadMeshlets(const std::shared_ptr<Devices> &devices, const MeshletData &data);
+
+// std140
+struct MeshletCullParams {
+	std::array<std::array<float, 4>, 6> planes; // as `FrustumCullPushConstants::planes`
+	std::array<float, 16> viewProjection; // column-major; only used for Hi-Z
+	std::array<float, 4> cameraPosition; // xyz
+	std::array<float, 2> pyramidSize;
+	uint32_t mipCount;
+	uint32_t meshletCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t padding[2];
+};
+
+/*
+ Culls meshlets on the GPU by frustum, normal cone and, if `hiZ`, against a `HiZOcclusionCuller`'s pyramid (see 'shaders/MeshletCull.comp', which is compiled with `HI_Z` defined for the latter).
+ A `VkDrawIndexedIndirectCommand` is appended for each surviving meshlet, drawing its range of `MeshletData::indices`, with `firstInstance` set to the meshlet's index. Draw them with `RenderPipeline::CmdDrawIndexedIndirectCount`, passing `DrawCommands()` and `DrawCount()`.
+ The meshlets are assumed to be in world space. `CmdCull` must be recorded outside a render pass, after `HiZOcclusionCuller::CmdBuildPyramid` if `hiZ`. Requires `Devices::SupportsDrawIndirectFirstInstance`.
+ */
+template <const char *filename, bool hiZ=false>
+class MeshletCuller {
+public:
+	using shader_t = std::conditional_t<hiZ,
+	Shader<VK_SHADER_STAGE_COMPUTE_BIT, filename, NoPushConstants,
+	UBOUniform<0, 0, MeshletCullParams>,
+	SBOUniform<0, 1>, // meshlets
+	SBOUniform<0, 2>, // draw commands
+	SBOUniform<0, 3>, // draw count
+	CombinedImageSamplersUniform<0, 4> // pyramid
+	>,
+	Shader<VK_SHADER_STAGE_COMPUTE_BIT, filename, NoPushConstants,
+	UBOUniform<0, 0, MeshletCullParams>,
+	SBOUniform<0, 1>,
+	SBOUniform<0, 2>,
+	SBOUniform<0, 3>
+	>>;
+	
+	static constexpr uint32_t workGroupSize = 64;
+	
+	MeshletCuller(std::shared_ptr<Devices> _devices, uint32_t _maxMeshlets)
+	: devices(_devices),
+	maxMeshlets(_maxMeshlets),
+	pipeline(_devices),
+	params(std::make_shared<UniformBufferObject<MeshletCullParams>>(_devices)),
+	drawCommands(std::make_shared<StorageBufferObject>(_devices, VkDeviceSize(_maxMeshlets) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)),
+	drawCount(std::make_shared<StorageBufferObject>(_devices, sizeof(uint32_t), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+		if(!devices->SupportsDrawIndirectFirstInstance()){
+			throw std::runtime_error("failed to create meshlet culler; drawIndirectFirstInstance is not supported!");
+		}
+		pipeline.template iDescriptorSet<0>().template iDescriptor<0>().Set(params);
+		pipeline.template iDescriptorSet<0>().template iDescriptor<2>().Set(drawCommands);
+		pipeline.template iDescriptorSet<0>().template iDescriptor<3>().Set(drawCount);
+	}
+	
+	void SetMeshlets(const MeshletBuffers &buffers){
+		meshletCount = buffers.meshletCount;
+		pipeline.template iDescriptorSet<0>().template iDescriptor<1>().Set(buffers.meshlets);
+	}
+	
+	// Must be called again after the pyramid is recreated (see `HiZOcclusionCuller::SetDepthImage`)
+	void SetPyramid(const std::shared_ptr<TextureImage> &_pyramid, const std::shared_ptr<TextureSampler> &sampler) requires (hiZ) {
+		pyramid = _pyramid;
+		pipeline.template iDescriptorSet<0>().template iDescriptor<4>().Set({{{_pyramid, sampler}}});
+	}
+	
+	// `firstIndex` and `vertexOffset` locate the reordered mesh within its buffers, e.g. from `GeometryPool::GetMesh`. `cullParams`' remaining fields are filled in here.
+	[[nodiscard]]
+	bool CmdCull(const CommandEnvironment &commandEnvironment, MeshletCullParams cullParams, uint32_t firstIndex, int32_t vertexOffset){
+		if(meshletCount > maxMeshlets){
+			std::cout << "Cannot cull meshlets; there are more than the maximum.\n";
+			return false;
+		}
+		cullParams.meshletCount = meshletCount;
+		cullParams.firstIndex = firstIndex;
+		cullParams.vertexOffset = vertexOffset;
+		if constexpr (hiZ){
+			if(!pyramid){
+				std::cout << "Cannot cull meshlets; no Hi-Z pyramid.\n";
+				return false;
+			}
+			cullParams.pyramidSize = {float(pyramid->Extent().width), float(pyramid->Extent().height)};
+			cullParams.mipCount = pyramid->MipLevels();
+		}
+		*params->GetDataPointer(commandEnvironment.flight) = cullParams;
+		
+		// resetting this flight's count
+		vkCmdFillBuffer(commandEnvironment.commandBuffer, drawCount->BufferFlying(commandEnvironment.flight), commandEnvironment.flight * drawCount->FlightStride(), sizeof(uint32_t), 0);
+		const VkMemoryBarrier resetBarrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		};
+		vkCmdPipelineBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+		
+		pipeline.CmdBind(commandEnvironment.commandBuffer);
+		if(!pipeline.CmdBindDescriptorSets(commandEnvironment.commandBuffer, commandEnvironment.flight)){
+			return false;
+		}
+		vkCmdDispatch(commandEnvironment.commandBuffer, (meshletCount + workGroupSize - 1) / workGroupSize, 1, 1);
+		
+		// making the commands and count visible to indirect draws
+		const VkMemoryBarrier cullBarrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+		};
+		vkCmdPipelineBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+		return true;
+	}
+	
+	[[nodiscard]] const StorageBufferObject &DrawCommands() const { return *drawCommands; }
+	[[nodiscard]] const StorageBufferObject &DrawCount() const { return *drawCount; }
+	[[nodiscard]] uint32_t MaxMeshlets() const { return maxMeshlets; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t maxMeshlets;
+	uint32_t meshletCount = 0;
+	ComputePipeline<shader_t> pipeline;
+	std::shared_ptr<UniformBufferObject<MeshletCullParams>> params;
+	std::shared_ptr<StorageBufferObject> drawCommands;
+	std::shared_ptr<StorageBufferObject> drawCount;
+	std::shared_ptr<TextureImage> pyramid {};
+};
+
+} // namespace EVK
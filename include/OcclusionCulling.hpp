@@ -0,0 +1,245 @@
+#pragma once
+
+#include <bit>
+
+#include "IndirectCulling.hpp"
+
+namespace EVK {
+
+struct HiZPyramidPushConstants {
+	uint32_t dstMip; // 0 reads the depth image, otherwise the pyramid's level `dstMip - 1`
+	uint32_t srcWidth;
+	uint32_t srcHeight;
+	uint32_t dstWidth;
+	uint32_t dstHeight;
+};
+
+struct HiZCullPushConstants {
+	std::array<float, 16> viewProjection; // column-major, the same as was used to render the occluders
+	std::array<float, 2> pyramidSize;
+	uint32_t mipCount;
+	uint32_t instanceCount;
+};
+
+/*
+ Hierarchical-Z occlusion culling. Each frame:
+ 1. render the occluders' depth with a `DepthPipeline` into `depthImage`, in a render pass leaving it in `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`;
+ 2. `CmdBuildPyramid` reduces it into a mip chain holding each region's furthest depth (see 'shaders/HiZPyramid.comp');
+ 3. `CmdCull` tests each instance's bounding sphere against the pyramid (see 'shaders/HiZCull.comp').
+ The visible instances' draws are appended to `DrawCommands()` and counted in `DrawCount()`, as with `FrustumCuller`, and `Visibility()` holds a `uint32_t` per instance, for `CmdBeginConditionalRendering`.
+ Depth is assumed to increase with distance. Everything is recorded outside a render pass. Requires `shaderStorageImageArrayDynamicIndexing` and `Devices::SupportsDrawIndirectFirstInstance`.
+ `maxMipCount` must match `MAX_MIP_COUNT` in 'shaders/HiZPyramid.comp'.
+ */
+template <const char *pyramidFilename, const char *cullFilename, uint32_t maxMipCount=16>
+class HiZOcclusionCuller {
+public:
+	using pyramidShader_t = Shader<VK_SHADER_STAGE_COMPUTE_BIT, pyramidFilename, PushConstants<0, HiZPyramidPushConstants>,
+	CombinedImageSamplersUniform<0, 0>, // depth
+	StorageImageMipsUniform<0, 1, maxMipCount> // pyramid levels
+	>;
+	using cullShader_t = Shader<VK_SHADER_STAGE_COMPUTE_BIT, cullFilename, PushConstants<0, HiZCullPushConstants>,
+	SBOUniform<0, 0>, // instances
+	SBOUniform<0, 1>, // meshes
+	SBOUniform<0, 2>, // draw commands
+	SBOUniform<0, 3>, // draw count
+	SBOUniform<0, 4>, // visibility
+	CombinedImageSamplersUniform<0, 5> // pyramid
+	>;
+	
+	static constexpr uint32_t pyramidWorkGroupSize = 8;
+	static constexpr uint32_t cullWorkGroupSize = 64;
+	
+	HiZOcclusionCuller(std::shared_ptr<Devices> _devices, const std::shared_ptr<TextureImage> &depthImage, uint32_t _maxInstances)
+	: devices(_devices),
+	maxInstances(_maxInstances),
+	pyramidPipeline(_devices),
+	cullPipeline(_devices),
+	drawCommands(std::make_shared<StorageBufferObject>(_devices, VkDeviceSize(_maxInstances) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)),
+	drawCount(std::make_shared<StorageBufferObject>(_devices, sizeof(uint32_t), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)),
+	visibility(std::make_shared<StorageBufferObject>(_devices, VkDeviceSize(_maxInstances) * sizeof(uint32_t), _devices->SupportsConditionalRendering() ? VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT : 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)),
+	sampler(std::make_shared<TextureSampler>(_devices, VkSamplerCreateInfo{
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.magFilter = VK_FILTER_NEAREST,
+		.minFilter = VK_FILTER_NEAREST,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.minLod = 0.0f,
+		.maxLod = VK_LOD_CLAMP_NONE
+	})) {
+		if(!devices->GetFeatures().shaderStorageImageArrayDynamicIndexing){
+			throw std::runtime_error("failed to create Hi-Z occlusion culler; shaderStorageImageArrayDynamicIndexing is not supported!");
+		}
+		if(!devices->SupportsDrawIndirectFirstInstance()){
+			throw std::runtime_error("failed to create Hi-Z occlusion culler; drawIndirectFirstInstance is not supported!");
+		}
+		cullPipeline.template iDescriptorSet<0>().template iDescriptor<2>().Set(drawCommands);
+		cullPipeline.template iDescriptorSet<0>().template iDescriptor<3>().Set(drawCount);
+		cullPipeline.template iDescriptorSet<0>().template iDescriptor<4>().Set(visibility);
+		SetDepthImage(depthImage);
+	}
+	
+	// Recreates the pyramid to match `depthImage`, e.g. after the window has been resized
+	void SetDepthImage(const std::shared_ptr<TextureImage> &depthImage){
+		const VkExtent3D &extent = depthImage->Extent();
+		mipCount = std::min(uint32_t(std::bit_width(std::max(extent.width, extent.height))), maxMipCount);
+		pyramid = std::make_shared<TextureImage>(devices, ManualImageBlueprint{
+			.imageCI = {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+				.imageType = VK_IMAGE_TYPE_2D,
+				.extent = {extent.width, extent.height, 1},
+				.mipLevels = mipCount,
+				.arrayLayers = 1,
+				.format = VK_FORMAT_R32_SFLOAT,
+				.tiling = VK_IMAGE_TILING_OPTIMAL,
+				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+				.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				.samples = VK_SAMPLE_COUNT_1_BIT,
+				.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+			},
+			.imageViewType = VK_IMAGE_VIEW_TYPE_2D,
+			.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipViews = true
+		});
+		// the pyramid is left ready to be sampled, as at the end of `CmdBuildPyramid`
+		VkCommandBuffer commandBuffer = devices->BeginSingleTimeCommands();
+		pyramid->CmdPipelineMemoryBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1});
+		devices->EndSingleTimeCommands(commandBuffer);
+		
+		pyramidPipeline.template iDescriptorSet<0>().template iDescriptor<0>().Set({{{depthImage, sampler}}});
+		pyramidPipeline.template iDescriptorSet<0>().template iDescriptor<1>().Set(pyramid);
+		cullPipeline.template iDescriptorSet<0>().template iDescriptor<5>().Set({{{pyramid, sampler}}});
+	}
+	
+	// `instances` holds up to `maxInstances` `CullingInstance`s
+	void SetInstances(const std::shared_ptr<StorageBufferObject> &instances){
+		cullPipeline.template iDescriptorSet<0>().template iDescriptor<0>().Set(instances);
+	}
+	// `meshes` holds the `GeometryPool::Mesh`es that `CullingInstance::mesh` indexes
+	void SetMeshes(const std::shared_ptr<StorageBufferObject> &meshes){
+		cullPipeline.template iDescriptorSet<0>().template iDescriptor<1>().Set(meshes);
+	}
+	
+	// Record after the occluders' depth has been rendered
+	[[nodiscard]]
+	bool CmdBuildPyramid(const CommandEnvironment &commandEnvironment){
+		const VkImageSubresourceRange allMips = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1};
+		// the previous contents are not needed, but any previous culling must have finished reading them
+		pyramid->CmdPipelineMemoryBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, allMips);
+		
+		pyramidPipeline.CmdBind(commandEnvironment.commandBuffer);
+		if(!pyramidPipeline.CmdBindDescriptorSets(commandEnvironment.commandBuffer, commandEnvironment.flight)){
+			return false;
+		}
+		const VkExtent3D &extent = pyramid->Extent();
+		HiZPyramidPushConstants pushConstants{
+			.dstMip = 0,
+			.srcWidth = extent.width,
+			.srcHeight = extent.height,
+			.dstWidth = extent.width,
+			.dstHeight = extent.height
+		};
+		for(uint32_t mip=0; mip<mipCount; ++mip){
+			if(mip > 0){
+				// each level is reduced from the one before
+				pyramid->CmdPipelineMemoryBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, {VK_IMAGE_ASPECT_COLOR_BIT, mip - 1, 1, 0, 1});
+				pushConstants.dstMip = mip;
+				pushConstants.srcWidth = pushConstants.dstWidth;
+				pushConstants.srcHeight = pushConstants.dstHeight;
+				pushConstants.dstWidth = std::max(pushConstants.dstWidth / 2, 1u);
+				pushConstants.dstHeight = std::max(pushConstants.dstHeight / 2, 1u);
+			}
+			pyramidPipeline.template CmdPushConstants<0>(commandEnvironment.commandBuffer, &pushConstants);
+			vkCmdDispatch(commandEnvironment.commandBuffer, (pushConstants.dstWidth + pyramidWorkGroupSize - 1) / pyramidWorkGroupSize, (pushConstants.dstHeight + pyramidWorkGroupSize - 1) / pyramidWorkGroupSize, 1);
+		}
+		
+		pyramid->CmdPipelineMemoryBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, allMips);
+		return true;
+	}
+	
+	// Record after `CmdBuildPyramid`
+	[[nodiscard]]
+	bool CmdCull(const CommandEnvironment &commandEnvironment, const std::array<float, 16> &viewProjection, uint32_t instanceCount){
+		if(instanceCount > maxInstances){
+			std::cout << "Cannot cull instances; there are more than the maximum.\n";
+			return false;
+		}
+		
+		// resetting this flight's count
+		vkCmdFillBuffer(commandEnvironment.commandBuffer, drawCount->BufferFlying(commandEnvironment.flight), commandEnvironment.flight * drawCount->FlightStride(), sizeof(uint32_t), 0);
+		const VkMemoryBarrier resetBarrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		};
+		vkCmdPipelineBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+		
+		cullPipeline.CmdBind(commandEnvironment.commandBuffer);
+		if(!cullPipeline.CmdBindDescriptorSets(commandEnvironment.commandBuffer, commandEnvironment.flight)){
+			return false;
+		}
+		const VkExtent3D &extent = pyramid->Extent();
+		HiZCullPushConstants pushConstants{
+			.viewProjection = viewProjection,
+			.pyramidSize = {float(extent.width), float(extent.height)},
+			.mipCount = mipCount,
+			.instanceCount = instanceCount
+		};
+		cullPipeline.template CmdPushConstants<0>(commandEnvironment.commandBuffer, &pushConstants);
+		vkCmdDispatch(commandEnvironment.commandBuffer, (instanceCount + cullWorkGroupSize - 1) / cullWorkGroupSize, 1, 1);
+		
+		// making the results visible to indirect draws and conditional rendering
+		VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+		VkAccessFlags dstAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		if(devices->SupportsConditionalRendering()){
+			dstStages |= VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
+			dstAccess |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
+		}
+		const VkMemoryBarrier cullBarrier{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+			.dstAccessMask = dstAccess
+		};
+		vkCmdPipelineBarrier(commandEnvironment.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStages, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+		return true;
+	}
+	
+	// Subsequent draws are discarded if `instance` was occluded. Requires `Devices::SupportsConditionalRendering`.
+	[[nodiscard]]
+	bool CmdBeginConditionalRendering(const CommandEnvironment &commandEnvironment, uint32_t instance) const {
+		if(!devices->SupportsConditionalRendering()){
+			std::cout << "Cannot begin conditional rendering; VK_EXT_conditional_rendering is not supported.\n";
+			return false;
+		}
+		devices->CmdBeginConditionalRendering(commandEnvironment.commandBuffer, visibility->BufferFlying(commandEnvironment.flight), commandEnvironment.flight * visibility->FlightStride() + VkDeviceSize(instance) * sizeof(uint32_t));
+		return true;
+	}
+	void CmdEndConditionalRendering(const CommandEnvironment &commandEnvironment) const {
+		devices->CmdEndConditionalRendering(commandEnvironment.commandBuffer);
+	}
+	
+	[[nodiscard]] const StorageBufferObject &DrawCommands() const { return *drawCommands; }
+	[[nodiscard]] const StorageBufferObject &DrawCount() const { return *drawCount; }
+	[[nodiscard]] const StorageBufferObject &Visibility() const { return *visibility; }
+	[[nodiscard]] const std::shared_ptr<TextureImage> &Pyramid() const { return pyramid; }
+	// nearest filtering, for sampling the pyramid elsewhere (e.g. `MeshletCuller::SetPyramid`)
+	[[nodiscard]] const std::shared_ptr<TextureSampler> &Sampler() const { return sampler; }
+	[[nodiscard]] uint32_t MaxInstances() const { return maxInstances; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t maxInstances;
+	uint32_t mipCount;
+	ComputePipeline<pyramidShader_t> pyramidPipeline;
+	ComputePipeline<cullShader_t> cullPipeline;
+	std::shared_ptr<StorageBufferObject> drawCommands;
+	std::shared_ptr<StorageBufferObject> drawCount;
+	std::shared_ptr<StorageBufferObject> visibility;
+	std::shared_ptr<TextureSampler> sampler;
+	std::shared_ptr<TextureImage> pyramid {};
+};
+
+} // namespace EVK
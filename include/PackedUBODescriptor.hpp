@@ -0,0 +1,72 @@
+#pragma once
+
+#include "DescriptorBase.hpp"
+
+namespace EVK {
+
+// A uniform buffer descriptor of a `FlightReplication::PACKED` UBO; the flight's copy is selected with a dynamic offset, so one descriptor set serves every flight
+template <uint32_t binding, VkShaderStageFlags stageFlags, typename T>
+class PackedUBODescriptor : public DescriptorBase<binding, stageFlags> {
+public:
+	using DescriptorBase = typename PackedUBODescriptor::DescriptorBase;
+	static constexpr uint32_t bindingValue = binding;
+	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
+	
+	PackedUBODescriptor() = default;
+	
+	void Set(const std::shared_ptr<UniformBufferObject<T, false>> &value){
+		if(value && value->Replication() != FlightReplication::PACKED){
+			std::cout << "Cannot set packed UBO descriptor; UBO is not packed.\n";
+			return;
+		}
+		object = value;
+		DescriptorBase::valid = false;
+	}
+	
+	static constexpr VkDescriptorSetLayoutBinding layoutBinding  = {
+		.binding = binding,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.descriptorCount = 1,
+		.stageFlags = stageFlags,
+		.pImmutableSamplers = nullptr
+	};
+	
+	std::optional<VkWriteDescriptorSet> DescriptorWrite(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight) const override {
+		if(!object){
+			return {};
+		}
+		
+		// the same buffer for every flight; the dynamic offset selects the flight's copy
+		bufferInfoBuffer[bufferInfoBufferIndex].buffer = object->BufferFlying(flight);
+		bufferInfoBuffer[bufferInfoBufferIndex].offset = 0;
+		bufferInfoBuffer[bufferInfoBufferIndex].range = object->Size();
+		
+		return (VkWriteDescriptorSet){
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = dstSet,
+			.dstBinding = binding,
+			.dstArrayElement = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+			.descriptorCount = 1,
+			.pBufferInfo = &bufferInfoBuffer[bufferInfoBufferIndex++]
+		};
+	}
+	
+	static constexpr VkDescriptorPoolSize poolSize = {
+		.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.descriptorCount = 1 * MAX_FRAMES_IN_FLIGHT
+	};
+	
+	std::optional<uint32_t> FlightDynamicOffset(uint32_t flight) const override {
+		if(!object){
+			return {};
+		}
+		return uint32_t(flight * object->FlightStride());
+	}
+	
+private:
+	std::shared_ptr<UniformBufferObject<T, false>> object {};
+};
+
+} // namespace EVK
@@ -3,12 +3,13 @@
 #include <optional>
 #include <memory>
 #include <cstddef>
+#include <map>
 
-#include "Devices.hpp"
+#include "Defragmenter.hpp"
 
 namespace EVK {
 
-class VertexBufferObject {
+class VertexBufferObject : public Relocatable {
 public:
 	VertexBufferObject(std::shared_ptr<Devices> _devices) : devices(std::move(_devices)) {}
 	~VertexBufferObject(){
@@ -18,6 +19,10 @@ public:
 	[[nodiscard]] bool Filled() const { return contents.has_value(); }
 	
 	void Fill(const std::vector<Devices::DeviceMemory> &vertexMemory, const VkDeviceSize &offset=0);
+	// `writer` is given the mapped memory to write the `size` bytes of vertex data into directly
+	void Fill(VkDeviceSize size, const Devices::MemoryWriter &writer, const VkDeviceSize &offset=0);
+	// Use the host memory at `hostPointer` as the vertex buffer directly, without copying (see `Devices::ImportHostBuffer`). Returns false if the memory could not be imported.
+	[[nodiscard]] bool Import(void *hostPointer, VkDeviceSize size, const VkDeviceSize &offset=0);
 	
 	[[nodiscard]]
 	bool CmdBind(VkCommandBuffer commandBuffer, uint32_t binding){
@@ -29,6 +34,9 @@ public:
 		return true;
 	}
 	
+	bool CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation) override;
+	void FinishRelocation(VmaAllocation srcAllocation) override;
+	
 private:
 	std::shared_ptr<Devices> devices;
 	
@@ -37,13 +45,16 @@ private:
 		VkDeviceSize offset;
 		VmaAllocation allocation;
 		VkDeviceSize size;
+		VkDeviceMemory importedMemory = VK_NULL_HANDLE; // instead of `allocation`, if the contents are imported host memory
 	};
 	std::optional<Contents> contents {};
 	
+	std::optional<VkBuffer> relocatedBuffer {};
+	
 	void CleanUpContents();
 };
 
-class IndexBufferObject {
+class IndexBufferObject : public Relocatable {
 public:
 	IndexBufferObject(std::shared_ptr<Devices> _devices) : devices(std::move(_devices)) {}
 	~IndexBufferObject(){
@@ -53,6 +64,8 @@ public:
 	[[nodiscard]] bool Filled() const { return contents.has_value(); }
 	
 	void Fill(size_t indexSize, const std::vector<Devices::DeviceMemory> &indexMemory, const VkDeviceSize &offset=0);
+	// `writer` is given the mapped memory to write the `indexCount` indices into directly
+	void Fill(size_t indexSize, uint32_t indexCount, const Devices::MemoryWriter &writer, const VkDeviceSize &offset=0);
 	
 	[[nodiscard]]
 	bool CmdBind(VkCommandBuffer commandBuffer, VkIndexType type){
@@ -70,6 +83,9 @@ public:
 		
 	}
 	
+	bool CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation) override;
+	void FinishRelocation(VmaAllocation srcAllocation) override;
+	
 private:
 	std::shared_ptr<Devices> devices;
 	
@@ -78,26 +94,89 @@ private:
 		VkDeviceSize offset;
 		VmaAllocation allocation;
 		uint32_t indexCount;
+		VkDeviceSize size;
 	};
 	std::optional<Contents> contents {};
 	
+	std::optional<VkBuffer> relocatedBuffer {};
+	
 	void CleanUpContents();
 };
 
 
+/*
+ How many copies of a buffer are kept for the frames in flight.
+ `STATIC` keeps a single buffer shared by every flight, for data that is written once (lookup tables, read-only storage); it must only be rewritten while no frames are in flight.
+ `PER_FLIGHT` keeps one buffer per flight, so the host can rewrite the current flight's copy while the GPU reads the others.
+ `PING_PONG` is `PER_FLIGHT` for compute read/write pairs: a descriptor may bind the buffer of the previous flight (see `FlightRole`), so each frame reads what the last one wrote.
+ `PACKED` keeps every flight's copy back to back in a single buffer, `FlightStride()` apart. It must be bound through a packed uniform (`PackedUBOUniform`, `PackedSBOUniform`), which selects the flight with a dynamic offset, so the descriptor set does not need a copy per flight.
+ */
+enum class FlightReplication {
+	STATIC,
+	PER_FLIGHT,
+	PING_PONG,
+	PACKED
+};
+// Which flight's copy of a `FlightReplication::PING_PONG` buffer a descriptor refers to
+enum class FlightRole {
+	CURRENT,
+	PREVIOUS
+};
+
 struct DynamicUBOInfo {
 	uint32_t repeatsN;
 	VkDeviceSize alignment;
 };
 
+// A view of `count` objects `stride` bytes apart, such as the repeats of a dynamic UBO; unlike a vector of pointers, it needn't be allocated
+template <typename T>
+class StridedView {
+public:
+	class Iterator {
+	public:
+		Iterator(uint8_t *_pointer, VkDeviceSize _stride) : pointer(_pointer), stride(_stride) {}
+		
+		T &operator*() const { return *reinterpret_cast<T *>(pointer); }
+		T *operator->() const { return reinterpret_cast<T *>(pointer); }
+		Iterator &operator++(){
+			pointer += stride;
+			return *this;
+		}
+		bool operator==(const Iterator &other) const { return pointer == other.pointer; }
+		
+	private:
+		uint8_t *pointer;
+		VkDeviceSize stride;
+	};
+	
+	StridedView(T *_start, VkDeviceSize _stride, uint32_t _count)
+	: start(reinterpret_cast<uint8_t *>(_start)), stride(_stride), count(_count) {}
+	
+	[[nodiscard]] T &operator[](uint32_t index) const { return *reinterpret_cast<T *>(start + index * stride); }
+	[[nodiscard]] uint32_t size() const { return count; }
+	[[nodiscard]] Iterator begin() const { return {start, stride}; }
+	[[nodiscard]] Iterator end() const { return {start + count * stride, stride}; }
+	
+private:
+	uint8_t *start;
+	VkDeviceSize stride;
+	uint32_t count;
+};
+
 template <typename T, bool dynamic=false>
 class UniformBufferObject {
 public:
-	UniformBufferObject(std::shared_ptr<Devices> _devices, uint32_t dynamicRepeats=1)
-	: devices(std::move(_devices)) {
+	UniformBufferObject(std::shared_ptr<Devices> _devices, uint32_t dynamicRepeats=1, FlightReplication _replication=FlightReplication::PER_FLIGHT)
+	: devices(std::move(_devices)), replication(_replication) {
 		if(dynamicRepeats < 1){
 			throw std::runtime_error("UBO dynamic repeats cannot be zero.");
 		}
+		if(replication == FlightReplication::PING_PONG){
+			throw std::runtime_error("UBOs cannot be ping-ponged; use `FlightReplication::PER_FLIGHT`.");
+		}
+		if(dynamic && replication == FlightReplication::PACKED){
+			throw std::runtime_error("Dynamic UBOs cannot be packed.");
+		}
 		if constexpr (dynamic){
 			// Calculate required alignment based on minimum device offset alignment
 			const VkDeviceSize minUboAlignment = devices->GetPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment;
@@ -111,25 +190,42 @@ public:
 			dynamicInfo.reset();
 			size = sizeof(T);
 		}
-		for(size_t i=0; i<MAX_FRAMES_IN_FLIGHT; ++i){
-			devices->CreateBuffer(size,
+		if(replication == FlightReplication::PACKED){
+			const VkDeviceSize minUboAlignment = devices->GetPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment;
+			flightStride = minUboAlignment > 0 ? (size + minUboAlignment - 1) & ~(minUboAlignment - 1) : size;
+		}
+		for(size_t i=0; i<Copies(); ++i){
+			devices->CreateBuffer(BufferSize(),
 								  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 								  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 								  buffersFlying[i],
 								  allocationsFlying[i],
-								  &(allocationInfosFlying[i]));
+								  &(allocationInfosFlying[i]),
+								  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT); // the GPU reads this every frame, so device local if it is also mappable
 		}
 	}
 	~UniformBufferObject(){
-		for(int i=0; i<MAX_FRAMES_IN_FLIGHT; i++){
-			vmaDestroyBuffer(devices->GetAllocator(), buffersFlying[i], allocationsFlying[i]);
+		for(int i=0; i<Copies(); i++){
+			devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = buffersFlying[i], allocation = allocationsFlying[i]](){
+				vmaDestroyBuffer(allocator, buffer, allocation);
+			});
 		}
 	}
 	
 	// ----- Modifying UBO data -----
 	[[nodiscard]]
 	T *GetDataPointer(uint32_t flight) const {
-		return static_cast<T *>(allocationInfosFlying[flight].pMappedData);
+		return reinterpret_cast<T *>(static_cast<uint8_t *>(allocationInfosFlying[CopyIndex(flight)].pMappedData) + flight * flightStride);
+	}
+	
+	// The repeats of a dynamic UBO, or the single object otherwise, without allocating
+	[[nodiscard]]
+	StridedView<T> GetDataView(uint32_t flight) const {
+		if constexpr (dynamic){
+			return {GetDataPointer(flight), dynamicInfo->alignment, dynamicInfo->repeatsN};
+		} else {
+			return {GetDataPointer(flight), sizeof(T), 1};
+		}
 	}
 	
 	[[nodiscard]]
@@ -137,52 +233,110 @@ public:
 		std::vector<T *> ret {};
 		if constexpr (dynamic){
 			ret.resize(dynamicInfo->repeatsN);
-			uint8_t *start = static_cast<uint8_t *>(allocationInfosFlying[flight].pMappedData);
+			uint8_t *start = static_cast<uint8_t *>(allocationInfosFlying[CopyIndex(flight)].pMappedData);
 			for(T* &ptr : ret){
 				ptr = (T *)start;
 				start += dynamicInfo->alignment;
 			}
 		} else {
-			ret.push_back(static_cast<T *>(allocationInfosFlying[flight].pMappedData));
+			ret.push_back(GetDataPointer(flight));
 		}
 		return ret;
 	}
 	
-	[[nodiscard]] VkBuffer BufferFlying(uint32_t flight) const { return buffersFlying[flight]; }
+	[[nodiscard]] VkBuffer BufferFlying(uint32_t flight) const { return buffersFlying[CopyIndex(flight)]; }
 	[[nodiscard]] VkDeviceSize Size() const { return size; }
 	[[nodiscard]] const std::optional<DynamicUBOInfo> &GetDynamic() const { return dynamicInfo; }
+	[[nodiscard]] FlightReplication Replication() const { return replication; }
+	// distance between flights' copies in the buffer if `FlightReplication::PACKED`, otherwise 0
+	[[nodiscard]] VkDeviceSize FlightStride() const { return flightStride; }
 	
 private:
 	std::shared_ptr<Devices> devices;
 	
+	FlightReplication replication;
 	VkBuffer buffersFlying[MAX_FRAMES_IN_FLIGHT];
 	VmaAllocation allocationsFlying[MAX_FRAMES_IN_FLIGHT];
 	VmaAllocationInfo allocationInfosFlying[MAX_FRAMES_IN_FLIGHT];
 	VkDeviceSize size;
+	VkDeviceSize flightStride = 0;
 	
 	std::optional<DynamicUBOInfo> dynamicInfo;
+	
+	int Copies() const { return replication == FlightReplication::STATIC || replication == FlightReplication::PACKED ? 1 : MAX_FRAMES_IN_FLIGHT; }
+	uint32_t CopyIndex(uint32_t flight) const { return replication == FlightReplication::STATIC || replication == FlightReplication::PACKED ? 0 : flight; }
+	VkDeviceSize BufferSize() const { return replication == FlightReplication::PACKED ? flightStride * MAX_FRAMES_IN_FLIGHT : size; }
 };
 
-class StorageBufferObject {
+class StorageBufferObject : public Relocatable {
 public:
 	StorageBufferObject(std::shared_ptr<Devices> _devices,
 						VkDeviceSize _size,
 						VkBufferUsageFlags usages,
-						VkMemoryPropertyFlags memoryProperties);
+						VkMemoryPropertyFlags memoryProperties,
+						FlightReplication _replication=FlightReplication::PER_FLIGHT);
+	/*
+	 Uses the host memory at `hostPointer` (e.g. an mmap'd file region) as the buffer directly, without copying (see `Devices::ImportHostBuffer`).
+	 The buffer is shared by all frames in flight (`FlightReplication::STATIC`), so it is best suited to read-only data. Throws if the memory could not be imported; check `Devices::SupportsHostMemoryImport` first.
+	 */
+	StorageBufferObject(std::shared_ptr<Devices> _devices,
+						void *hostPointer,
+						VkDeviceSize _size,
+						VkBufferUsageFlags usages);
 	~StorageBufferObject(){
-		for(int i=0; i<MAX_FRAMES_IN_FLIGHT; i++){
-			vmaDestroyBuffer(devices->GetAllocator(), buffersFlying[i], allocationsFlying[i]);
+		if(importedMemory){
+			devices->EnqueueDestruction([logicalDevice = devices->GetLogicalDevice(), buffer = buffersFlying[0], memory = importedMemory](){
+				vkDestroyBuffer(logicalDevice, buffer, nullptr);
+				vkFreeMemory(logicalDevice, memory, nullptr);
+			});
+			return;
+		}
+		for(int i=0; i<Copies(); i++){
+			UnsetRelocatable(devices->GetAllocator(), allocationsFlying[i]);
+			devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = buffersFlying[i], allocation = allocationsFlying[i]](){
+				vmaDestroyBuffer(allocator, buffer, allocation);
+			});
 		}
 	}
 	
 	[[nodiscard]] bool Fill(const std::byte *data);
+	// `writer` is given the mapped memory to write the `Size()` bytes of data into directly
+	[[nodiscard]] bool Fill(const Devices::MemoryWriter &writer);
 	
 	void CmdBindAsVertexBuffer(const CommandEnvironment &commandEnvironment, uint32_t binding, const VkDeviceSize &offset){
-		vkCmdBindVertexBuffers(commandEnvironment.commandBuffer, binding, 1, &buffersFlying[commandEnvironment.flight], &offset);
+		const VkDeviceSize flightOffset = offset + commandEnvironment.flight * flightStride;
+		vkCmdBindVertexBuffers(commandEnvironment.commandBuffer, binding, 1, &buffersFlying[CopyIndex(commandEnvironment.flight)], &flightOffset);
 	}
 	
-	[[nodiscard]] VkBuffer BufferFlying(uint32_t flight) const { return buffersFlying[flight]; }
+	[[nodiscard]] VkBuffer BufferFlying(uint32_t flight, FlightRole role=FlightRole::CURRENT) const {
+		if(role == FlightRole::PREVIOUS && replication == FlightReplication::PING_PONG){
+			flight = (flight + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+		}
+		return buffersFlying[CopyIndex(flight)];
+	}
 	[[nodiscard]] VkDeviceSize Size() const { return size; }
+	[[nodiscard]] FlightReplication Replication() const { return replication; }
+	// distance between flights' copies in the buffer if `FlightReplication::PACKED`, otherwise 0
+	[[nodiscard]] VkDeviceSize FlightStride() const { return flightStride; }
+	// the distance between elements of `elementSize` bytes such that each can be bound on its own with a dynamic offset (see `DynamicSBOUniform`)
+	[[nodiscard]] VkDeviceSize DynamicStride(VkDeviceSize elementSize) const {
+		const VkDeviceSize minSboAlignment = devices->GetPhysicalDeviceProperties().limits.minStorageBufferOffsetAlignment;
+		return minSboAlignment > 0 ? (elementSize + minSboAlignment - 1) & ~(minSboAlignment - 1) : elementSize;
+	}
+	/*
+	 The GPU address of `flight`'s copy, for shaders to reach the buffer through a `buffer_reference` (e.g. passed in push constants) rather than a descriptor. The buffer must be created with `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT` in `usages`.
+	 The address changes if the buffer is relocated by the defragmenter (see `HandleVersion`), so get it when recording rather than keeping it.
+	 */
+	[[nodiscard]] VkDeviceAddress DeviceAddress(uint32_t flight, FlightRole role=FlightRole::CURRENT) const {
+		if(!(usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)){
+			std::cout << "Cannot get storage buffer device address; it was not created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT.\n";
+			return 0;
+		}
+		return devices->BufferDeviceAddress(BufferFlying(flight, role)) + (replication == FlightReplication::PACKED ? flight * flightStride : 0);
+	}
+	
+	bool CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation) override;
+	void FinishRelocation(VmaAllocation srcAllocation) override;
 	
 private:
 	std::shared_ptr<Devices> devices;
@@ -191,11 +345,150 @@ private:
 	VmaAllocation allocationsFlying[MAX_FRAMES_IN_FLIGHT];
 	VmaAllocationInfo allocationInfosFlying[MAX_FRAMES_IN_FLIGHT];
 	VkDeviceSize size;
+	VkBufferUsageFlags usage;
+	FlightReplication replication;
+	VkDeviceSize flightStride = 0;
+	VkDeviceMemory importedMemory = VK_NULL_HANDLE; // backs the buffer if constructed from host memory
+	
+	std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> relocatedBuffersFlying {};
+	
+	int Copies() const { return replication == FlightReplication::STATIC || replication == FlightReplication::PACKED ? 1 : MAX_FRAMES_IN_FLIGHT; }
+	uint32_t CopyIndex(uint32_t flight) const { return replication == FlightReplication::STATIC || replication == FlightReplication::PACKED ? 0 : flight; }
+	VkDeviceSize BufferSize() const { return replication == FlightReplication::PACKED ? flightStride * MAX_FRAMES_IN_FLIGHT : size; }
+};
+
+/*
+ A persistently mapped buffer for data that is rewritten every frame, partitioned into one region per frame in flight.
+ Call `BeginFlight` with the current flight at the start of each frame (after `EVK::Interface::BeginFrame`), which resets that flight's partition. Sub-allocations are then handed out with a bump pointer, so no memory is allocated and nothing is staged per frame.
+ */
+class TransientRingBuffer {
+public:
+	TransientRingBuffer(std::shared_ptr<Devices> _devices,
+						VkDeviceSize sizePerFlight,
+						VkBufferUsageFlags usages=VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	~TransientRingBuffer(){
+		devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = buffer, allocation = allocation](){
+			vmaDestroyBuffer(allocator, buffer, allocation);
+		});
+	}
+	
+	TransientRingBuffer(const TransientRingBuffer &) = delete;
+	TransientRingBuffer &operator=(const TransientRingBuffer &) = delete;
+	
+	struct Allocation {
+		void *data;
+		VkDeviceSize offset; // from the start of the whole buffer
+		VkDeviceSize size;
+	};
+	
+	void BeginFlight(uint32_t flight){
+		currentFlight = flight;
+		head = 0;
+	}
+	
+	[[nodiscard]] std::optional<Allocation> Allocate(VkDeviceSize size, VkDeviceSize alignment=16);
+	[[nodiscard]] std::optional<Allocation> AllocateUniform(VkDeviceSize size){ return Allocate(size, uniformAlignment); }
+	[[nodiscard]] std::optional<Allocation> AllocateStorage(VkDeviceSize size){ return Allocate(size, storageAlignment); }
+	
+	void CmdBindAsVertexBuffer(VkCommandBuffer commandBuffer, uint32_t binding, const Allocation &allocation) const {
+		vkCmdBindVertexBuffers(commandBuffer, binding, 1, &buffer, &allocation.offset);
+	}
+	void CmdBindAsIndexBuffer(VkCommandBuffer commandBuffer, const Allocation &allocation, VkIndexType type) const {
+		vkCmdBindIndexBuffer(commandBuffer, buffer, allocation.offset, type);
+	}
+	
+	// The number to pass in the dynamic offset numbers when binding descriptor sets containing a `RingUBODescriptor` of this buffer. `allocation` must have come from `AllocateUniform`.
+	[[nodiscard]] int DynamicOffsetNumber(const Allocation &allocation) const { return int(allocation.offset / uniformAlignment); }
+	
+	[[nodiscard]] VkBuffer Buffer() const { return buffer; }
+	[[nodiscard]] VkDeviceSize PartitionSize() const { return partitionSize; }
+	[[nodiscard]] VkDeviceSize UniformAlignment() const { return uniformAlignment; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	VkBuffer buffer;
+	VmaAllocation allocation;
+	VmaAllocationInfo allocationInfo;
+	
+	VkDeviceSize uniformAlignment;
+	VkDeviceSize storageAlignment;
+	VkDeviceSize partitionSize;
+	
+	uint32_t currentFlight = 0;
+	VkDeviceSize head = 0;
+};
+
+/*
+ Per-instance vertex attributes, rewritten each frame. Each frame in flight has its own persistently mapped copy (in device local memory if it is mappable), so writing the current flight's instances needs no staging or synchronisation.
+ Bind with `CmdBind<vertexShader_t, binding>`, which checks at compile time that `binding` of the shader's attributes is instance-rate and matches `T`, then draw with an instance count.
+ */
+template <typename T>
+class InstanceBuffer {
+public:
+	InstanceBuffer(std::shared_ptr<Devices> _devices, uint32_t _capacity)
+	: devices(std::move(_devices)), capacity(_capacity) {
+		if(capacity == 0){
+			throw std::runtime_error("Instance buffer capacity cannot be zero.");
+		}
+		for(int i=0; i<MAX_FRAMES_IN_FLIGHT; ++i){
+			devices->CreateBuffer(VkDeviceSize(capacity) * sizeof(T),
+								  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+								  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+								  buffersFlying[i],
+								  allocationsFlying[i],
+								  &(allocationInfosFlying[i]),
+								  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+	~InstanceBuffer(){
+		for(int i=0; i<MAX_FRAMES_IN_FLIGHT; ++i){
+			devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = buffersFlying[i], allocation = allocationsFlying[i]](){
+				vmaDestroyBuffer(allocator, buffer, allocation);
+			});
+		}
+	}
+	
+	InstanceBuffer(const InstanceBuffer &) = delete;
+	InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+	
+	// The flight's `Capacity()` instances, to be written directly
+	[[nodiscard]] std::span<T> Data(uint32_t flight) const {
+		return {static_cast<T *>(allocationInfosFlying[flight].pMappedData), capacity};
+	}
+	
+	[[nodiscard]]
+	bool Write(uint32_t flight, std::span<const T> instances, uint32_t firstInstance=0) const {
+		if(firstInstance + instances.size() > capacity){
+			std::cout << "Cannot write instances; there are more than the buffer's capacity.\n";
+			return false;
+		}
+		memcpy(Data(flight).data() + firstInstance, instances.data(), instances.size_bytes());
+		return true;
+	}
+	
+	template <typename vertexShader_t, uint32_t binding>
+	void CmdBind(const CommandEnvironment &commandEnvironment) const {
+		static_assert(vertexShader_t::vertexAttributes_t::template InstanceBindingMatches<binding, T>(), "Instance binding should be instance-rate, with the instance type's size as stride and all attributes inside it.");
+		const VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandEnvironment.commandBuffer, binding, 1, &buffersFlying[commandEnvironment.flight], &offset);
+	}
+	
+	[[nodiscard]] uint32_t Capacity() const { return capacity; }
+	[[nodiscard]] VkBuffer BufferFlying(uint32_t flight) const { return buffersFlying[flight]; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t capacity;
+	VkBuffer buffersFlying[MAX_FRAMES_IN_FLIGHT];
+	VmaAllocation allocationsFlying[MAX_FRAMES_IN_FLIGHT];
+	VmaAllocationInfo allocationInfosFlying[MAX_FRAMES_IN_FLIGHT];
 };
 
 struct PNGImageBlueprint {
 	std::string imageFilename;
-	
+	bool streamed = false; // see `DataImageBlueprint::streamed`
 };
 struct DataImageBlueprint {
 	uint8_t *data;
@@ -204,6 +497,17 @@ struct DataImageBlueprint {
 	uint32_t pitch;
 	VkFormat format;
 	bool mip;
+	// keep a host copy of the mip chain so the texture's resident mips can be changed by a `EVK::TextureResidencyManager`. Starts with only the smallest mip resident. Requires a 4-byte texel format.
+	bool streamed = false;
+};
+// the pixels are written by `writer` directly into the upload memory, which has size `height * pitch`
+struct GeneratedImageBlueprint {
+	uint32_t width;
+	uint32_t height;
+	uint32_t pitch;
+	VkFormat format;
+	bool mip;
+	Devices::MemoryWriter writer;
 };
 struct Data3DImageBlueprint {
 	uint8_t *data;
@@ -221,18 +525,26 @@ struct ManualImageBlueprint {
 	VkImageViewType imageViewType;
 	VkMemoryPropertyFlags properties;
 	VkImageAspectFlags aspectFlags;
+	bool mipViews = false; // also create a view of each mip level, for binding the levels individually (see `StorageImageMipsDescriptor`)
 };
 
-class TextureImage {
+class TextureImage : public Relocatable {
 public:
 	TextureImage(std::shared_ptr<Devices> _devices, const PNGImageBlueprint &fromPNG);
 	TextureImage(std::shared_ptr<Devices> _devices, const DataImageBlueprint &fromRaw);
+	TextureImage(std::shared_ptr<Devices> _devices, const GeneratedImageBlueprint &generated);
 	TextureImage(std::shared_ptr<Devices> _devices, const Data3DImageBlueprint &fromRaw3D);
 	TextureImage(std::shared_ptr<Devices> _devices, const CubemapPNGImageBlueprint &fromPNGCubemaps);
 	TextureImage(std::shared_ptr<Devices> _devices, const ManualImageBlueprint &manual);
 	~TextureImage(){
-		vkDestroyImageView(devices->GetLogicalDevice(), view, nullptr);
-		vmaDestroyImage(devices->GetAllocator(), image, allocation);
+		UnsetRelocatable(devices->GetAllocator(), allocation);
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), allocator = devices->GetAllocator(), image = image, allocation = allocation, view = view, mipViews = std::move(mipViews)](){
+			for(VkImageView mipView : mipViews){
+				vkDestroyImageView(device, mipView, nullptr);
+			}
+			vkDestroyImageView(device, view, nullptr);
+			vmaDestroyImage(allocator, image, allocation);
+		});
 	}
 	
 	void CmdPipelineMemoryBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, VkImageSubresourceRange subresourceRange){
@@ -258,6 +570,25 @@ public:
 	[[nodiscard]] const VkExtent3D &Extent() const { return extent; }
 	[[nodiscard]] VkFormat Format() const { return format; }
 	[[nodiscard]] VkImage Image() const { return image; }
+	// only available for manual images created with `ManualImageBlueprint::mipViews`
+	[[nodiscard]] bool HasMipViews() const { return !mipViews.empty(); }
+	[[nodiscard]] VkImageView MipView(uint32_t mip) const { return mipViews.at(mip); }
+	
+	// ----- Mip streaming -----
+	[[nodiscard]] bool Streamed() const { return streaming.has_value(); }
+	[[nodiscard]] uint32_t MipLevels() const { return mipLevels; }
+	// the most detailed mip level currently in device memory; `Extent()` is the extent of this level
+	[[nodiscard]] uint32_t ResidentBaseMip() const { return streaming ? streaming->residentBaseMip : 0; }
+	[[nodiscard]] VkDeviceSize ResidentSize() const;
+	// the texel data size of the mip chain starting at `baseMip`
+	[[nodiscard]] VkDeviceSize StreamedSize(uint32_t baseMip) const;
+	// Recreates the image with only levels `baseMip` and below, recording their upload from the host copy into `commandBuffer`, which must be outside a render pass. The old image is destroyed once the frame has finished, but descriptors bound earlier in `commandBuffer` would refer to it, so record this before binding any.
+	[[nodiscard]] bool CmdSetResidentBaseMip(VkCommandBuffer commandBuffer, uint32_t baseMip);
+	// As `CmdSetResidentBaseMip`, but submitted immediately, waiting for the upload
+	[[nodiscard]] bool SetResidentBaseMip(uint32_t baseMip);
+	
+	bool CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation) override;
+	void FinishRelocation(VmaAllocation srcAllocation) override;
 	
 	template <typename T>
 	[[nodiscard]] std::vector<T> GetData(const VkOffset3D &sourceStart={0, 0, 0}, VkOffset3D sourceEnd={0, 0, 0}) const {
@@ -382,12 +713,32 @@ private:
 	VkImage image;
 	VmaAllocation allocation;
 	VkImageView view;
+	std::vector<VkImageView> mipViews {};
 	uint32_t mipLevels;
 	VkExtent3D extent;
 	VkFormat format;
 	
+	// only set for images whose contents evk manages (i.e. not manual images), which can be moved by the defragmenter
+	struct RelocationInfo {
+		VkImageCreateInfo imageCI;
+		VkImageViewCreateInfo imageViewCI;
+		VkImageLayout layout;
+	};
+	std::optional<RelocationInfo> relocationInfo {};
+	std::optional<VkImage> relocatedImage {};
+	
+	struct Streaming {
+		VkExtent2D fullExtent;
+		std::vector<std::vector<uint8_t>> hostMips;
+		uint32_t residentBaseMip;
+	};
+	std::optional<Streaming> streaming {};
+	
 	void ConstructFromData(DataImageBlueprint _blueprint);
+	void ConstructGenerated(const GeneratedImageBlueprint &_blueprint);
+	void ConstructStreamed(DataImageBlueprint _blueprint);
 	void ConstructManual(ManualImageBlueprint _blueprint);
+	void MakeRelocatable(const VkImageCreateInfo &imageCI, const VkImageViewCreateInfo &imageViewCI, VkImageLayout layout);
 };
 
 class TextureSampler {
@@ -395,7 +746,9 @@ public:
 	TextureSampler(std::shared_ptr<Devices> _devices,
 				   const VkSamplerCreateInfo &samplerCI);
 	~TextureSampler(){
-		vkDestroySampler(devices->GetLogicalDevice(), handle, nullptr);
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), handle = handle](){
+			vkDestroySampler(device, handle, nullptr);
+		});
 	}
 	
 	[[nodiscard]] VkSampler Handle() const { return handle; }
@@ -406,13 +759,60 @@ private:
 	VkSampler handle;
 };
 
+/*
+ The slots of a `BindlessTexturesDescriptor`. Each added texture is given an index into the descriptor's array, which shaders use to pick it (e.g. from a material's push constants), so materials need no descriptor sets of their own.
+ Free slots hold the fallback texture. A removed slot keeps its texture until every frame that may be sampling it has finished, and is only then reused.
+ */
+class BindlessTextureTable {
+public:
+	struct Slot {
+		std::shared_ptr<TextureImage> image;
+		std::shared_ptr<TextureSampler> sampler;
+	};
+	
+	BindlessTextureTable(std::shared_ptr<Devices> _devices, uint32_t _capacity, const Slot &_fallback);
+	
+	// Adding the same image and sampler again returns the same index; each `Add` needs a matching `Remove`. Returns no value if the table is full.
+	[[nodiscard]] std::optional<uint32_t> Add(const std::shared_ptr<TextureImage> &image, const std::shared_ptr<TextureSampler> &sampler);
+	void Remove(uint32_t index);
+	
+	[[nodiscard]] const Slot &Get(uint32_t index) const { return slots[index]; }
+	[[nodiscard]] uint32_t Capacity() const { return capacity; }
+	// one past the highest index ever used
+	[[nodiscard]] uint32_t Used() const { return uint32_t(slots.size()); }
+	// incremented whenever a slot's texture changes, including when an image is moved by the defragmenter
+	[[nodiscard]] uint64_t HandleVersion() const { return *version; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	uint32_t capacity;
+	Slot fallback;
+	std::vector<Slot> slots {};
+	std::vector<uint32_t> references {};
+	std::map<std::pair<const TextureImage *, const TextureSampler *>, uint32_t> indices {};
+	std::vector<uint32_t> freeIndices {};
+	// shared with the slots' images, which increment it when relocated
+	std::shared_ptr<uint64_t> version = std::make_shared<uint64_t>(0);
+	
+	struct PendingFree {
+		uint64_t frame;
+		uint32_t index;
+	};
+	std::vector<PendingFree> pendingFrees {};
+	
+	void ReleasePendingFrees();
+};
+
 class BufferedRenderPass {
 public:
 	BufferedRenderPass(std::shared_ptr<Devices> _devices,
 					   const VkRenderPassCreateInfo *const pRenderPassCI);
 	~BufferedRenderPass(){
 		CleanUpTargets();
-		vkDestroyRenderPass(devices->GetLogicalDevice(), renderPass, nullptr);
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), renderPass = renderPass](){
+			vkDestroyRenderPass(device, renderPass, nullptr);
+		});
 	}
 	
 	[[nodiscard]]
@@ -467,10 +867,12 @@ private:
 		if(!targets){
 			return;
 		}
-		for(VkFramebuffer &fb : targets->frameBuffersFlying){
-			vkDestroyFramebuffer(devices->GetLogicalDevice(), fb, nullptr);
-		}
-		targets->images.clear();
+		// the images enqueue their own destruction when released below, after the framebuffers', so they outlive them
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), frameBuffersFlying = targets->frameBuffersFlying](){
+			for(VkFramebuffer fb : frameBuffersFlying){
+				vkDestroyFramebuffer(device, fb, nullptr);
+			}
+		});
 		targets.reset();
 	}
 };
@@ -490,7 +892,9 @@ public:
 	}
 	~LayeredBufferedRenderPass(){
 		CleanUpTargets();
-		vkDestroyRenderPass(devices->GetLogicalDevice(), renderPass, nullptr);
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), renderPass = renderPass](){
+			vkDestroyRenderPass(device, renderPass, nullptr);
+		});
 	}
 	
 	[[nodiscard]]
@@ -593,13 +997,15 @@ private:
 		if(!targets){
 			return;
 		}
-		for(int i=0; i<layersN; ++i){
-			vkDestroyImageView(devices->GetLogicalDevice(), targets->layers[i].imageView, nullptr);
-			for(VkFramebuffer &fb : targets->layers[i].frameBuffersFlying){
-				vkDestroyFramebuffer(devices->GetLogicalDevice(), fb, nullptr);
+		// the image enqueues its own destruction when released below, after its views' and the framebuffers', so it outlives them
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), layers = targets->layers](){
+			for(const typename Targets::Layer &layer : layers){
+				vkDestroyImageView(device, layer.imageView, nullptr);
+				for(VkFramebuffer fb : layer.frameBuffersFlying){
+					vkDestroyFramebuffer(device, fb, nullptr);
+				}
 			}
-		}
-		targets->image.reset();
+		});
 		targets.reset();
 	}
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "DescriptorBase.hpp"
+
+namespace EVK {
+
+// A dynamic uniform buffer descriptor of a `T` in a `TransientRingBuffer`; the dynamic offset number selects the allocation (see `TransientRingBuffer::DynamicOffsetNumber`)
+template <uint32_t binding, VkShaderStageFlags stageFlags, typename T>
+class RingUBODescriptor : public DescriptorBase<binding, stageFlags> {
+public:
+	using DescriptorBase = typename RingUBODescriptor::DescriptorBase;
+	static constexpr uint32_t bindingValue = binding;
+	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
+	static constexpr bool consumesDynamicOffsetNumber = true;
+	
+	RingUBODescriptor() = default;
+	
+	void Set(const std::shared_ptr<TransientRingBuffer> &value){
+		object = value;
+		DescriptorBase::valid = false;
+	}
+	
+	static constexpr VkDescriptorSetLayoutBinding layoutBinding  = {
+		.binding = binding,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.descriptorCount = 1,
+		.stageFlags = stageFlags,
+		.pImmutableSamplers = nullptr
+	};
+	
+	std::optional<VkWriteDescriptorSet> DescriptorWrite(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight) const override {
+		if(!object){
+			return {};
+		}
+		
+		// the same buffer for every flight; the dynamic offset lands in the flight's partition
+		bufferInfoBuffer[bufferInfoBufferIndex].buffer = object->Buffer();
+		bufferInfoBuffer[bufferInfoBufferIndex].offset = 0;
+		bufferInfoBuffer[bufferInfoBufferIndex].range = sizeof(T);
+		
+		return (VkWriteDescriptorSet){
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = dstSet,
+			.dstBinding = binding,
+			.dstArrayElement = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+			.descriptorCount = 1,
+			.pBufferInfo = &bufferInfoBuffer[bufferInfoBufferIndex++]
+		};
+	}
+	
+	static constexpr VkDescriptorPoolSize poolSize = {
+		.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.descriptorCount = 1 * MAX_FRAMES_IN_FLIGHT
+	};
+	
+	std::optional<DynamicUBOInfo> GetUBODynamic() const override {
+		if(!object){
+			std::cout << "Cannot get if UBO is dynamic; no object.\n";
+			return {};
+		}
+		return DynamicUBOInfo{
+			.repeatsN = uint32_t(object->PartitionSize() * MAX_FRAMES_IN_FLIGHT / object->UniformAlignment()),
+			.alignment = object->UniformAlignment()
+		};
+	}
+	
+private:
+	std::shared_ptr<TransientRingBuffer> object {};
+};
+
+} // namespace EVK
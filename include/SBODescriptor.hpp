@@ -10,12 +10,18 @@ public:
 	using DescriptorBase = typename SBODescriptor::DescriptorBase;
 	static constexpr uint32_t bindingValue = binding;
 	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = false;
 	
 	SBODescriptor() = default;
 	
-	void Set(const std::shared_ptr<StorageBufferObject> &value, int _flightOffset){
+	// `FlightRole::PREVIOUS` binds the buffer written by the previous frame, and requires a `FlightReplication::PING_PONG` buffer
+	void Set(const std::shared_ptr<StorageBufferObject> &value, FlightRole _role=FlightRole::CURRENT){
+		if(_role == FlightRole::PREVIOUS && value && value->Replication() != FlightReplication::PING_PONG){
+			std::cout << "Cannot bind previous flight's SBO; it is not ping-ponged. Binding the current flight's.\n";
+			_role = FlightRole::CURRENT;
+		}
 		object = value;
-		flightOffset = _flightOffset;
+		role = _role;
 		DescriptorBase::valid = false;
 	}
 	
@@ -32,7 +38,7 @@ public:
 			return {};
 		}
 		
-		bufferInfoBuffer[bufferInfoBufferIndex].buffer = object->BufferFlying(PositiveModulo(flight + flightOffset, MAX_FRAMES_IN_FLIGHT));
+		bufferInfoBuffer[bufferInfoBufferIndex].buffer = object->BufferFlying(flight, role);
 		bufferInfoBuffer[bufferInfoBufferIndex].offset = 0;
 		bufferInfoBuffer[bufferInfoBufferIndex].range = object->Size();
 		
@@ -47,6 +53,10 @@ public:
 		};
 	}
 	
+	uint64_t HandleVersion() const override {
+		return object ? object->HandleVersion() : 0;
+	}
+	
 	static constexpr VkDescriptorPoolSize poolSize = {
 		.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 		.descriptorCount = 1 * MAX_FRAMES_IN_FLIGHT
@@ -54,7 +64,7 @@ public:
 	
 private:
 	std::shared_ptr<StorageBufferObject> object {};
-	int flightOffset;
+	FlightRole role = FlightRole::CURRENT;
 };
 
 } // namespace EVK
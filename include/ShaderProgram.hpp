@@ -1,22 +1,32 @@
 #pragma once
 
+#include <cassert>
+
 #include "Static.hpp"
 
 #include "Devices.hpp"
 
 #include "UBODescriptor.hpp"
+#include "RingUBODescriptor.hpp"
+#include "PackedUBODescriptor.hpp"
 #include "SBODescriptor.hpp"
+#include "PackedSBODescriptor.hpp"
+#include "DynamicSBODescriptor.hpp"
 #include "TextureImagesDescriptor.hpp"
 #include "TextureSamplersDescriptor.hpp"
 #include "CombinedImageSamplersDescriptor.hpp"
 #include "StorageImagesDescriptor.hpp"
+#include "StorageImageMipsDescriptor.hpp"
+#include "BindlessTexturesDescriptor.hpp"
 
 namespace EVK {
 
 // Push constants
 // -----
 struct NoPushConstants {};
+// `T` may hold `VkDeviceAddress`es (e.g. from `StorageBufferObject::DeviceAddress`), matching `buffer_reference` members in the shader's push constant block
 template <size_t offset, typename T> struct PushConstants {
+	static_assert(offset % alignof(T) == 0, "Push constants should be placed at an offset aligned for their type; 8 bytes if they contain device addresses.");
 	static constexpr uint32_t offsetValue = offset;
 	using type = T;
 };
@@ -112,11 +122,31 @@ struct UBOUniform : public UniformBase<set, binding> {
 	template <VkShaderStageFlags stageFlags>
 	using descriptor_t = UBODescriptor<binding, stageFlags, T, dynamic>;
 };
+template <uint32_t set, uint32_t binding, typename T>
+struct RingUBOUniform : public UniformBase<set, binding> {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = RingUBODescriptor<binding, stageFlags, T>;
+};
+template <uint32_t set, uint32_t binding, typename T>
+struct PackedUBOUniform : public UniformBase<set, binding> {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = PackedUBODescriptor<binding, stageFlags, T>;
+};
 template <uint32_t set, uint32_t binding>
 struct SBOUniform : public UniformBase<set, binding> {
 	template <VkShaderStageFlags stageFlags>
 	using descriptor_t = SBODescriptor<binding, stageFlags>;
 };
+template <uint32_t set, uint32_t binding>
+struct PackedSBOUniform : public UniformBase<set, binding> {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = PackedSBODescriptor<binding, stageFlags>;
+};
+template <uint32_t set, uint32_t binding, typename T>
+struct DynamicSBOUniform : public UniformBase<set, binding> {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = DynamicSBODescriptor<binding, stageFlags, T>;
+};
 template <uint32_t set, uint32_t binding, uint32_t count=1>
 struct TextureImagesUniform : public UniformBase<set, binding> {
 	template <VkShaderStageFlags stageFlags>
@@ -137,6 +167,28 @@ struct StorageImagesUniform : public UniformBase<set, binding> {
 	template <VkShaderStageFlags stageFlags>
 	using descriptor_t = StorageImagesDescriptor<binding, stageFlags, count>;
 };
+template <uint32_t set, uint32_t binding, uint32_t mipCount>
+struct StorageImageMipsUniform : public UniformBase<set, binding> {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = StorageImageMipsDescriptor<binding, stageFlags, mipCount>;
+};
+template <uint32_t set, uint32_t binding, uint32_t capacity>
+struct BindlessTexturesUniform : public UniformBase<set, binding> {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = BindlessTexturesDescriptor<binding, stageFlags, capacity>;
+};
+
+// A descriptor whose set is recorded into command buffers with `CmdPushDescriptors` rather than allocated and bound
+template <typename descriptor_t>
+struct PushedDescriptor : public descriptor_t {
+	static constexpr bool pushDescriptor = true;
+};
+// Puts a uniform's set in push descriptor mode (requires `Devices::SupportsPushDescriptors`); every uniform in the set must be wrapped
+template <typename uniform_t>
+struct PushedUniform : public uniform_t {
+	template <VkShaderStageFlags stageFlags>
+	using descriptor_t = PushedDescriptor<typename uniform_t::template descriptor_t<stageFlags>>;
+};
 
 template <typename T>
 concept descriptor_c = requires (T val) {
@@ -144,6 +196,7 @@ concept descriptor_c = requires (T val) {
 	{T::stageFlagsValue} -> std::same_as<const uint32_t &>;
 	{T::layoutBinding} -> std::same_as<const VkDescriptorSetLayoutBinding&>;
 	{T::poolSize} -> std::same_as<const VkDescriptorPoolSize &>;
+	{T::flightInvariant} -> std::same_as<const bool &>;
 };
 
 struct NoDescriptorInDescriptorSetWithThatBinding{};
@@ -262,6 +315,35 @@ static consteval bool AllSmallerSetsExistInUniforms(){
 template <VkVertexInputBindingDescription... bindingDescriptions> struct BindingDescriptionPack {};
 template <VkVertexInputAttributeDescription... attributeDescriptions> struct AttributeDescriptionPack {};
 
+// Size in bytes of a vertex attribute of `format`; formats not known here fail to compile when evaluated at compile time, so they can't pass unchecked
+constexpr uint32_t VertexFormatSize(VkFormat format){
+	switch(format){
+		case VK_FORMAT_R8_UNORM: case VK_FORMAT_R8_SNORM: case VK_FORMAT_R8_UINT: case VK_FORMAT_R8_SINT:
+			return 1;
+		case VK_FORMAT_R8G8_UNORM: case VK_FORMAT_R8G8_SNORM: case VK_FORMAT_R8G8_UINT: case VK_FORMAT_R8G8_SINT:
+		case VK_FORMAT_R16_UNORM: case VK_FORMAT_R16_SNORM: case VK_FORMAT_R16_UINT: case VK_FORMAT_R16_SINT: case VK_FORMAT_R16_SFLOAT:
+			return 2;
+		case VK_FORMAT_R8G8B8_UNORM: case VK_FORMAT_R8G8B8_SNORM: case VK_FORMAT_R8G8B8_UINT: case VK_FORMAT_R8G8B8_SINT:
+			return 3;
+		case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SNORM: case VK_FORMAT_R8G8B8A8_UINT: case VK_FORMAT_R8G8B8A8_SINT:
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32: case VK_FORMAT_A2B10G10R10_SNORM_PACK32:
+		case VK_FORMAT_R16G16_UNORM: case VK_FORMAT_R16G16_SNORM: case VK_FORMAT_R16G16_UINT: case VK_FORMAT_R16G16_SINT: case VK_FORMAT_R16G16_SFLOAT:
+		case VK_FORMAT_R32_UINT: case VK_FORMAT_R32_SINT: case VK_FORMAT_R32_SFLOAT:
+			return 4;
+		case VK_FORMAT_R16G16B16_UNORM: case VK_FORMAT_R16G16B16_SNORM: case VK_FORMAT_R16G16B16_UINT: case VK_FORMAT_R16G16B16_SINT: case VK_FORMAT_R16G16B16_SFLOAT:
+			return 6;
+		case VK_FORMAT_R16G16B16A16_UNORM: case VK_FORMAT_R16G16B16A16_SNORM: case VK_FORMAT_R16G16B16A16_UINT: case VK_FORMAT_R16G16B16A16_SINT: case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R32G32_UINT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32_UINT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32_SFLOAT:
+			return 12;
+		case VK_FORMAT_R32G32B32A32_UINT: case VK_FORMAT_R32G32B32A32_SINT: case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			throw std::invalid_argument("unknown vertex attribute format; add its size to `VertexFormatSize`");
+	}
+}
+
 struct PipelineVertexInputStateCreateInfoSafe {
 	std::vector<VkVertexInputBindingDescription> binding;
 	std::vector<VkVertexInputAttributeDescription> attribute;
@@ -279,6 +361,14 @@ struct Attributes<BindingDescriptionPack<bindingDescriptions...>, AttributeDescr
 	
 	static_assert(Unique<attributeDescriptions.location...>(), "Vertex input attribute description locations should be unique.");
 	
+	// Whether `binding` is an instance-rate binding whose stride is `sizeof(T)`, with all of its attributes inside `T`
+	template <uint32_t binding, typename T>
+	static consteval bool InstanceBindingMatches(){
+		return ((bindingDescriptions.binding == binding) || ...)
+		&& ((bindingDescriptions.binding != binding || (bindingDescriptions.inputRate == VK_VERTEX_INPUT_RATE_INSTANCE && bindingDescriptions.stride == sizeof(T))) && ...)
+		&& ((attributeDescriptions.binding != binding || attributeDescriptions.offset + VertexFormatSize(attributeDescriptions.format) <= sizeof(T)) && ...);
+	}
+	
 //	static constexpr VkVertexInputBindingDescription bindingDescriptionsValue[bindingDescriptionCount] = {(bindingDescriptions, ...)};
 //	
 //	static constexpr VkVertexInputAttributeDescription attributeDescriptionsValue[attributeDescriptionCount] = {(attributeDescriptions, ...)};
@@ -315,6 +405,65 @@ struct Attributes<BindingDescriptionPack<bindingDescriptions...>, AttributeDescr
 
 // Descriptor set
 // -----
+// A descriptor's `VkDescriptorBindingFlags`, for those that declare any
+template <typename T>
+consteval VkDescriptorBindingFlags DescriptorBindingFlags(){
+	if constexpr (requires { {T::bindingFlags} -> std::convertible_to<VkDescriptorBindingFlags>; }){
+		return T::bindingFlags;
+	} else {
+		return 0;
+	}
+}
+
+// Whether a descriptor type is written with `VkDescriptorImageInfo`s rather than `VkDescriptorBufferInfo`s
+consteval bool IsImageDescriptorType(VkDescriptorType type){
+	return type == VK_DESCRIPTOR_TYPE_SAMPLER || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE || type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+}
+
+template <typename T>
+consteval bool IsPushDescriptor(){
+	if constexpr (requires { {T::pushDescriptor} -> std::convertible_to<bool>; }){
+		return T::pushDescriptor;
+	} else {
+		return false;
+	}
+}
+
+consteval bool IsDynamicDescriptorType(VkDescriptorType type){
+	return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+}
+
+// Whether a dynamic descriptor's offset is chosen by a dynamic offset number when binding, e.g. a dynamic UBO, rather than only by the flight, e.g. a packed UBO
+template <typename T>
+consteval bool ConsumesDynamicOffsetNumber(){
+	if constexpr (requires { {T::consumesDynamicOffsetNumber} -> std::convertible_to<bool>; }){
+		return T::consumesDynamicOffsetNumber;
+	} else {
+		return false;
+	}
+}
+
+// Whether `dynamicOffsetNumbers` has one number per dynamic UBO or SBO being bound; fixed-size lists (e.g. a `dynamicOffsetNumbers_t`) are checked at compile time instead
+template <uint32_t count, typename numbers_t>
+bool DynamicOffsetNumbersMatch(const numbers_t &dynamicOffsetNumbers){
+	if constexpr (requires { std::tuple_size<numbers_t>::value; }){
+		static_assert(std::tuple_size_v<numbers_t> == count, "There should be one dynamic offset number per dynamic UBO or SBO in the bound sets; see `dynamicOffsetNumbers_t`.");
+		return true;
+	} else {
+		if(std::size(dynamicOffsetNumbers) != count){
+			std::cout << "Cannot bind descriptor sets; " << std::size(dynamicOffsetNumbers) << " dynamic offset numbers given for " << count << " dynamic UBOs or SBOs.\n";
+			return false;
+		}
+		return true;
+	}
+}
+
+// Partially bound descriptors write a varying number of elements, so are written with `vkUpdateDescriptorSets` rather than an update template
+template <typename T>
+consteval bool UsesUpdateTemplate(){
+	return !(DescriptorBindingFlags<T>() & VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+}
+
 template <typename descriptor_tp, typename indexSequence_t> struct DescriptorSetImpl;
 template <typename... descriptor_ts, uint32_t... indices>
 struct DescriptorSetImpl<TypePack<descriptor_ts...>, std::integer_sequence<uint32_t, indices...>> {
@@ -323,70 +472,210 @@ struct DescriptorSetImpl<TypePack<descriptor_ts...>, std::integer_sequence<uint3
 	
 	template <uint32_t index> using descriptor_t = descriptorByBinding_t<index, descriptor_ts...>;
 	
+	// if so, one descriptor set is shared by every flight
+	static constexpr bool flightInvariant = (descriptor_ts::flightInvariant && ...);
+	static constexpr int flightCopies = flightInvariant ? 1 : MAX_FRAMES_IN_FLIGHT;
+	
+	// descriptors that are updated after binding need the set's layout and pool to allow it
+	static constexpr bool updateAfterBind = ((DescriptorBindingFlags<descriptor_ts>() & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) || ...);
+	static constexpr bool hasBindingFlags = ((DescriptorBindingFlags<descriptor_ts>() != 0) || ...);
+	
+	// the descriptor count of a variable-count binding, which must be the last, or 0 if there is none
+	static constexpr uint32_t variableDescriptorCount = []() -> uint32_t {
+		if constexpr (descriptorCount == 0){
+			return 0;
+		} else {
+			using last_t = descriptor_t<descriptorCount - 1>;
+			return DescriptorBindingFlags<last_t>() & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT ? last_t::layoutBinding.descriptorCount : 0;
+		}
+	}();
+	static_assert(((indices + 1 == descriptorCount || !(DescriptorBindingFlags<descriptor_t<indices>>() & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT)) && ...), "A variable-count descriptor must have the highest binding in its set.");
+	
+	// push descriptor sets are never allocated; their descriptors are recorded straight into command buffers
+	static constexpr bool pushDescriptor = (IsPushDescriptor<descriptor_ts>() || ...);
+	static_assert(!pushDescriptor || (IsPushDescriptor<descriptor_ts>() && ...), "Either every or no uniform in a descriptor set should be pushed.");
+	static_assert(!pushDescriptor || (!hasBindingFlags && (!IsDynamicDescriptorType(descriptor_ts::layoutBinding.descriptorType) && ...)), "Push descriptor sets cannot contain dynamic buffers or descriptors with binding flags.");
+	
+	// descriptor buffers have no dynamic descriptors, and every binding behaves as if updated after bind
+	static constexpr bool descriptorBufferCompatible = !pushDescriptor && !hasBindingFlags && (!IsDynamicDescriptorType(descriptor_ts::layoutBinding.descriptorType) && ...);
+	
+	// the number of dynamic offsets the set is bound with, and how many of those take a dynamic offset number
+	static constexpr uint32_t dynamicOffsetCount = (0 + ... + (IsDynamicDescriptorType(descriptor_ts::layoutBinding.descriptorType) ? 1 : 0));
+	static constexpr uint32_t dynamicOffsetNumberCount = (0 + ... + (ConsumesDynamicOffsetNumber<descriptor_ts>() ? 1 : 0));
+	
+	// the number of infos needed to write every descriptor in the set at once
+	static constexpr uint32_t imageInfoCount = (0 + ... + (IsImageDescriptorType(descriptor_ts::layoutBinding.descriptorType) ? descriptor_ts::layoutBinding.descriptorCount : 0));
+	static constexpr uint32_t bufferInfoCount = (0 + ... + (IsImageDescriptorType(descriptor_ts::layoutBinding.descriptorType) ? 0 : descriptor_ts::layoutBinding.descriptorCount));
+	
 	// needs to have default constructor jsut so that UniformsImpl can initialise in body of its constructor
 	DescriptorSetImpl(){}
 	
 	explicit DescriptorSetImpl(std::shared_ptr<Devices> _devices)
 	: devices(_devices) {}
 	
-	VkDescriptorSetLayout CreateLayout() const {
-		std::array<VkDescriptorSetLayoutBinding, descriptorCount> layoutBindings {};
-		size_t i = 0;
-		(void(layoutBindings[i++] = descriptor_t<indices>::layoutBinding), ...);
-		// binding flags
-//		std::array<VkDescriptorBindingFlags, descriptorCount> flags{};
-//		std::ranges::fill(flags, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
-//		const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlags{
-//			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
-//			.pNext = nullptr,
-//			.pBindingFlags = flags.data(),
-//			.bindingCount = descriptorCount
-//		};
+	// the layout's bindings and their binding flags, in binding order
+	static constexpr std::array<VkDescriptorSetLayoutBinding, descriptorCount> layoutBindings = {descriptor_t<indices>::layoutBinding...};
+	static constexpr std::array<VkDescriptorBindingFlags, descriptorCount> layoutBindingFlags = {DescriptorBindingFlags<descriptor_t<indices>>()...};
+	
+	// the pool sizes needed for a single instance of the set; descriptors' own pool sizes provide for a set per flight
+	static constexpr std::array<VkDescriptorPoolSize, descriptorCount> setPoolSizes = {(VkDescriptorPoolSize){
+		.type = descriptor_t<indices>::poolSize.type,
+		.descriptorCount = descriptor_t<indices>::poolSize.descriptorCount / MAX_FRAMES_IN_FLIGHT
+	}...};
+	
+	// Whether layouts created from this and `other_t` are identically defined, so sets of either can be bound with pipeline layouts made with the other
+	template <typename other_t>
+	static consteval bool IdenticallyDefined(){
+		if constexpr (other_t::descriptorCount != descriptorCount || other_t::pushDescriptor != pushDescriptor){
+			return false;
+		} else {
+			for(uint32_t i=0; i<descriptorCount; ++i){
+				const VkDescriptorSetLayoutBinding &mine = layoutBindings[i];
+				const VkDescriptorSetLayoutBinding &theirs = other_t::layoutBindings[i];
+				if(mine.binding != theirs.binding || mine.descriptorType != theirs.descriptorType || mine.descriptorCount != theirs.descriptorCount || mine.stageFlags != theirs.stageFlags || layoutBindingFlags[i] != other_t::layoutBindingFlags[i]){
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+	
+	// a compile-time identity of the layout's contents, for `Devices::CachedDescriptorSetLayout`
+	static constexpr uint64_t layoutHash = [](){
+		uint64_t ret = HashCombine(hashSeed, descriptorCount);
+		for(uint32_t i=0; i<descriptorCount; ++i){
+			ret = HashCombine(ret, layoutBindings[i].binding);
+			ret = HashCombine(ret, layoutBindings[i].descriptorType);
+			ret = HashCombine(ret, layoutBindings[i].descriptorCount);
+			ret = HashCombine(ret, layoutBindings[i].stageFlags);
+			ret = HashCombine(ret, layoutBindingFlags[i]);
+		}
+		return ret;
+	}();
+	
+	// The layout comes from `Devices`' layout cache, which owns it, so every set with an identical layout has the same handle
+	VkDescriptorSetLayout CachedLayout(bool descriptorBuffer=false) const {
+		const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlags{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+			.bindingCount = descriptorCount,
+			.pBindingFlags = layoutBindingFlags.data()
+		};
 		const VkDescriptorSetLayoutCreateInfo layoutInfo{
 			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-//			.pNext = &bindingFlags,
+			.pNext = hasBindingFlags ? &bindingFlags : nullptr,
+			.flags = descriptorBuffer ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : pushDescriptor ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : VkDescriptorSetLayoutCreateFlags(0),
 			.bindingCount = descriptorCount,
 			.pBindings = layoutBindings.data()
 		};
-		VkDescriptorSetLayout handle;
-		if(vkCreateDescriptorSetLayout(devices->GetLogicalDevice(), &layoutInfo, nullptr, &handle) != VK_SUCCESS){
-			throw std::runtime_error("failed to create descriptor set layout!");
+		return devices->CachedDescriptorSetLayout(HashCombine(layoutHash, layoutInfo.flags), layoutInfo);
+	}
+	
+	// One single-entry update template per descriptor, so each binding can be written on its own
+	static constexpr std::array<VkDescriptorUpdateTemplateEntry, descriptorCount> updateTemplateEntries = {(VkDescriptorUpdateTemplateEntry){
+		.dstBinding = descriptor_t<indices>::layoutBinding.binding,
+		.dstArrayElement = 0,
+		.descriptorCount = descriptor_t<indices>::layoutBinding.descriptorCount,
+		.descriptorType = descriptor_t<indices>::layoutBinding.descriptorType,
+		.offset = 0,
+		.stride = IsImageDescriptorType(descriptor_t<indices>::layoutBinding.descriptorType) ? sizeof(VkDescriptorImageInfo) : sizeof(VkDescriptorBufferInfo)
+	}...};
+	
+	void CreateUpdateTemplates(VkDescriptorSetLayout layout){
+		if constexpr (pushDescriptor){
+			return;
+		}
+		([&](){
+			if constexpr (UsesUpdateTemplate<descriptor_t<indices>>()){
+				const VkDescriptorUpdateTemplateCreateInfo templateInfo{
+					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+					.descriptorUpdateEntryCount = 1,
+					.pDescriptorUpdateEntries = &updateTemplateEntries[indices],
+					.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+					.descriptorSetLayout = layout
+				};
+				if(vkCreateDescriptorUpdateTemplate(devices->GetLogicalDevice(), &templateInfo, nullptr, &updateTemplates[indices]) != VK_SUCCESS){
+					throw std::runtime_error("failed to create descriptor update template!");
+				}
+			}
+		}(), ...);
+	}
+	// Uses update templates created by another instance of this set, e.g. for many instances of one layout; `owner` stays responsible for destroying them
+	void ShareUpdateTemplates(const DescriptorSetImpl &owner){
+		updateTemplates = owner.updateTemplates;
+	}
+	// Uses the binding offsets `owner` found with `InitDescriptorBuffer`
+	void ShareDescriptorBufferOffsets(const DescriptorSetImpl &owner){
+		descriptorBufferOffsets = owner.descriptorBufferOffsets;
+	}
+	void DestroyUpdateTemplates(){
+		for(VkDescriptorUpdateTemplate &updateTemplate : updateTemplates){
+			if(updateTemplate != VK_NULL_HANDLE){
+				vkDestroyDescriptorUpdateTemplate(devices->GetLogicalDevice(), updateTemplate, nullptr);
+				updateTemplate = VK_NULL_HANDLE;
+			}
 		}
-		return handle;
 	}
 	
-	bool Update(const std::function<const VkDescriptorSet &(uint32_t)> &dstSetFromFlight){
-		VkDescriptorBufferInfo bufferInfos[32];
-		VkDescriptorImageInfo imageInfos[256];
-		int bufferInfoCounter, imageInfoCounter;
-		
-		// configuring descriptors in descriptor sets
-		for(int i=0; i<MAX_FRAMES_IN_FLIGHT; i++){
-			std::vector<VkWriteDescriptorSet> descriptorWrites{};
-			
-			bufferInfoCounter = 0;
-			imageInfoCounter = 0;
-			
-			if(!([&]() -> bool {
-				const std::optional<VkWriteDescriptorSet> maybeDescriptorWrite = std::get<indices>(descriptors).DescriptorWrite(dstSetFromFlight(i), imageInfos, imageInfoCounter, bufferInfos, bufferInfoCounter, i);
-				if(!maybeDescriptorWrite){
-					return false;
+	// For a layout created for descriptor buffers, finds where each binding lives in the set's region of the buffer. Returns the size of the region.
+	VkDeviceSize InitDescriptorBuffer(VkDescriptorSetLayout layout){
+		(void(descriptorBufferOffsets[indices] = devices->DescriptorSetLayoutBindingOffset(layout, descriptor_t<indices>::layoutBinding.binding)), ...);
+		return devices->DescriptorSetLayoutSize(layout);
+	}
+	
+	// Writes the descriptors that have changed since they were last written to `flight`'s copy of the set, or to its region of a descriptor buffer if `descriptorData` is given. The two are tracked separately, so a set can be backed by both, e.g. when shared between pipelines that do and don't use descriptor buffers. Returns false if any cannot be written yet; they are retried on the next update.
+	bool Update(uint32_t flight, VkDescriptorSet dstSet, std::byte *descriptorData=nullptr){
+		// a changed descriptor is out of date in every flight's copy of the set, in both descriptor sets and descriptor buffers
+		([&](){
+			descriptor_t<indices> &descriptor = std::get<indices>(descriptors);
+			if(!descriptor.Valid()){
+				for(std::array<std::array<bool, descriptorCount>, flightCopies> &targetDirty : dirty){
+					for(std::array<bool, descriptorCount> &copyDirty : targetDirty){
+						copyDirty[indices] = true;
+					}
 				}
-				descriptorWrites.push_back(maybeDescriptorWrite.value());
+				descriptor.SetValid();
+			}
+		}(), ...);
+		
+		const uint32_t copy = flightInvariant ? 0 : flight;
+		std::array<bool, descriptorCount> &copyDirty = dirty[descriptorData != nullptr][copy];
+		return ([&]() -> bool {
+			if(!copyDirty[indices]){
 				return true;
-			}() && ...)){
+			}
+			if(!(descriptorData ? GetDescriptors<indices>(copy, descriptorData) : WriteDescriptor<indices>(copy, dstSet))){
+				return false;
+			}
+			copyDirty[indices] = false;
+			return true;
+		}() && ...);
+	}
+	
+	// Records every descriptor of a push descriptor set into `commandBuffer`. Returns false if any cannot be written yet.
+	bool CmdPush(VkCommandBuffer commandBuffer, uint32_t flight, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set) const requires (pushDescriptor) {
+		std::array<VkDescriptorImageInfo, imageInfoCount> imageInfos;
+		std::array<VkDescriptorBufferInfo, bufferInfoCount> bufferInfos;
+		std::array<VkWriteDescriptorSet, descriptorCount> writes;
+		int imageInfoCounter = 0;
+		int bufferInfoCounter = 0;
+		if(!([&]() -> bool {
+			const std::optional<VkWriteDescriptorSet> write = std::get<indices>(descriptors).DescriptorWrite(VK_NULL_HANDLE, imageInfos.data(), imageInfoCounter, bufferInfos.data(), bufferInfoCounter, int(flight));
+			if(!write){
 				return false;
 			}
-			vkUpdateDescriptorSets(devices->GetLogicalDevice(), uint32_t(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+			writes[indices] = write.value();
+			return true;
+		}() && ...)){
+			return false;
 		}
-		// telling descriptors that they are valid
-		(void(std::get<indices>(descriptors).SetValid()), ...);
-		
+		devices->CmdPushDescriptorSet(commandBuffer, bindPoint, layout, set, descriptorCount, writes.data());
 		return true;
 	}
 	
-	bool CheckDescriptorsValid() const {
-		return (std::get<indices>(descriptors).Valid() && ...);
+	// whether `flight`'s copy of the set is up to date, in its descriptor set or its region of a descriptor buffer
+	bool CheckDescriptorsValid(uint32_t flight, bool descriptorBuffer=false) const {
+		const uint32_t copy = flightInvariant ? 0 : flight;
+		return ((std::get<indices>(descriptors).Valid() && !dirty[descriptorBuffer][copy][indices]) && ...);
 	}
 	
 	template <uint32_t index>
@@ -394,18 +683,23 @@ struct DescriptorSetImpl<TypePack<descriptor_ts...>, std::integer_sequence<uint3
 		return std::get<index>(descriptors);
 	}
 	
-	std::optional<VkDeviceSize> GetUBODynamicAlignment() const {
-		std::optional<VkDeviceSize> ret {};
+	// Writes the `dynamicOffsetCount` dynamic offsets of this set's descriptors in binding order, advancing `dynamicOffsets` past them. Packed buffers' offsets select `flight`, while dynamic UBOs and SBOs each consume a number from `dynamicOffsetNumbers` (see `dynamicOffsetNumberCount`), selecting which element is bound. There must be a number for each (see `DynamicOffsetNumbersMatch`).
+	template <typename numbers_t>
+	void WriteDynamicOffsets(uint32_t flight, const numbers_t &dynamicOffsetNumbers, int &indexOfDynamic, uint32_t *&dynamicOffsets) const {
 		([&](){
-			if(std::optional<DynamicUBOInfo> mbdyn = std::get<indices>(descriptors).GetUBODynamic(); mbdyn.has_value()){
-				if(ret.has_value()){
-					throw std::runtime_error("A descriptor set can contain at most 1 uniform buffer object.");
-				} else {
-					ret = mbdyn->alignment;
+			using appended_t = descriptor_t<indices>;
+			if constexpr (IsDynamicDescriptorType(appended_t::layoutBinding.descriptorType)){
+				const appended_t &descriptor = std::get<indices>(descriptors);
+				VkDeviceSize offset = descriptor.FlightDynamicOffset(flight).value_or(0);
+				if constexpr (ConsumesDynamicOffsetNumber<appended_t>()){
+					assert(indexOfDynamic < int(std::size(dynamicOffsetNumbers)));
+					const VkDeviceSize number = VkDeviceSize(dynamicOffsetNumbers[indexOfDynamic]);
+					++indexOfDynamic;
+					offset += number * descriptor.DynamicStride().value_or(0);
 				}
+				*dynamicOffsets++ = uint32_t(offset);
 			}
 		}(), ...);
-		return ret;
 	}
 	
 private:
@@ -413,6 +707,120 @@ private:
 	
 	std::tuple<descriptor_t<indices>...> descriptors {};
 	
+	std::array<VkDescriptorUpdateTemplate, descriptorCount> updateTemplates {};
+	std::array<VkDeviceSize, descriptorCount> descriptorBufferOffsets {};
+	// indexed by whether the target is a descriptor buffer, then by copy
+	std::array<std::array<std::array<bool, descriptorCount>, flightCopies>, 2> dirty {};
+	
+	// writes of descriptors that don't use an update template, kept to reuse its storage
+	std::vector<VkWriteDescriptorSet> descriptorWrites {};
+	
+	template <uint32_t index>
+	bool WriteDescriptor(uint32_t copy, VkDescriptorSet dstSet){
+		using written_t = descriptor_t<index>;
+		const written_t &descriptor = std::get<index>(descriptors);
+		if constexpr (UsesUpdateTemplate<written_t>()){
+			// the infos are laid out as the descriptor's template entry expects
+			constexpr uint32_t count = written_t::layoutBinding.descriptorCount;
+			constexpr bool image = IsImageDescriptorType(written_t::layoutBinding.descriptorType);
+			std::array<VkDescriptorImageInfo, image ? count : 0> imageInfos;
+			std::array<VkDescriptorBufferInfo, image ? 0 : count> bufferInfos;
+			int imageInfoCounter = 0;
+			int bufferInfoCounter = 0;
+			const std::optional<VkWriteDescriptorSet> write = descriptor.DescriptorWrite(dstSet, imageInfos.data(), imageInfoCounter, bufferInfos.data(), bufferInfoCounter, int(copy));
+			if(!write){
+				return false;
+			}
+			const void *const data = image ? static_cast<const void *>(write->pImageInfo) : static_cast<const void *>(write->pBufferInfo);
+			vkUpdateDescriptorSetWithTemplate(devices->GetLogicalDevice(), dstSet, updateTemplates[index], data);
+		} else {
+			int imageInfoCounter = 0;
+			int bufferInfoCounter = 0;
+			descriptorWrites.clear();
+			if(!descriptor.DescriptorWrites(dstSet, nullptr, imageInfoCounter, nullptr, bufferInfoCounter, int(copy), descriptorWrites)){
+				return false;
+			}
+			if(!descriptorWrites.empty()){
+				vkUpdateDescriptorSets(devices->GetLogicalDevice(), uint32_t(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+			}
+		}
+		return true;
+	}
+	
+	// writing into descriptor buffer memory is just copying what `vkGetDescriptorEXT` gives for each element
+	template <uint32_t index>
+	bool GetDescriptors(uint32_t copy, std::byte *descriptorData) const {
+		using written_t = descriptor_t<index>;
+		constexpr VkDescriptorType type = written_t::layoutBinding.descriptorType;
+		constexpr uint32_t count = written_t::layoutBinding.descriptorCount;
+		constexpr bool image = IsImageDescriptorType(type);
+		std::array<VkDescriptorImageInfo, image ? count : 0> imageInfos;
+		std::array<VkDescriptorBufferInfo, image ? 0 : count> bufferInfos;
+		int imageInfoCounter = 0;
+		int bufferInfoCounter = 0;
+		const std::optional<VkWriteDescriptorSet> write = std::get<index>(descriptors).DescriptorWrite(VK_NULL_HANDLE, imageInfos.data(), imageInfoCounter, bufferInfos.data(), bufferInfoCounter, int(copy));
+		if(!write){
+			return false;
+		}
+		const size_t descriptorSize = devices->DescriptorSize(type);
+		std::byte *dst = descriptorData + descriptorBufferOffsets[index];
+		// unless the implementation has `combinedImageSamplerDescriptorSingleArray`, an array of combined image samplers is laid out as all of its images followed by all of its samplers
+		if constexpr (type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && count > 1){
+			if(!devices->DescriptorBufferProperties().combinedImageSamplerDescriptorSingleArray){
+				const size_t imageSize = devices->DescriptorSize(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+				const size_t samplerSize = devices->DescriptorSize(VK_DESCRIPTOR_TYPE_SAMPLER);
+				for(uint32_t i=0; i<count; ++i){
+					VkDescriptorGetInfoEXT imageGetInfo{
+						.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+						.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+					};
+					imageGetInfo.data.pSampledImage = &write->pImageInfo[i];
+					devices->GetDescriptor(imageGetInfo, imageSize, dst + i * imageSize);
+					VkDescriptorGetInfoEXT samplerGetInfo{
+						.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+						.type = VK_DESCRIPTOR_TYPE_SAMPLER
+					};
+					samplerGetInfo.data.pSampler = &write->pImageInfo[i].sampler;
+					devices->GetDescriptor(samplerGetInfo, samplerSize, dst + count * imageSize + i * samplerSize);
+				}
+				return true;
+			}
+		}
+		for(uint32_t i=0; i<count; ++i){
+			VkDescriptorGetInfoEXT getInfo{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+				.type = type
+			};
+			VkDescriptorAddressInfoEXT addressInfo;
+			if constexpr (type == VK_DESCRIPTOR_TYPE_SAMPLER){
+				getInfo.data.pSampler = &write->pImageInfo[i].sampler;
+			} else if constexpr (type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER){
+				getInfo.data.pCombinedImageSampler = &write->pImageInfo[i];
+			} else if constexpr (type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE){
+				getInfo.data.pSampledImage = &write->pImageInfo[i];
+			} else if constexpr (type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE){
+				getInfo.data.pStorageImage = &write->pImageInfo[i];
+			} else if constexpr (type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT){
+				getInfo.data.pInputAttachmentImage = &write->pImageInfo[i];
+			} else {
+				const VkDescriptorBufferInfo &bufferInfo = write->pBufferInfo[i];
+				addressInfo = {
+					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+					.address = devices->BufferDeviceAddress(bufferInfo.buffer) + bufferInfo.offset,
+					.range = bufferInfo.range,
+					.format = VK_FORMAT_UNDEFINED
+				};
+				if constexpr (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER){
+					getInfo.data.pUniformBuffer = &addressInfo;
+				} else {
+					getInfo.data.pStorageBuffer = &addressInfo;
+				}
+			}
+			devices->GetDescriptor(getInfo, descriptorSize, dst + i * descriptorSize);
+		}
+		return true;
+	}
+	
 	// ubo info
 //	std::optional<VkDeviceSize> uboDynamicAlignment;
 	
@@ -458,17 +866,57 @@ public:
 	static constexpr uint32_t uniformCount = sizeof...(uniformWithShaderStage_ts);
 //	static_assert((uint32_t descriptorSet_t<indices>::descriptorCount + ...) == uniformCount, "!Inconsistency");
 	
-	static consteval std::array<VkDescriptorPoolSize, uniformCount> PoolSizes(){
-		if constexpr (uniformCount == 0){
+	// descriptor sets shared by every flight, and the total number of descriptor sets allocated
+	static constexpr std::array<bool, descriptorSetCount> setsFlightInvariant = {descriptorSet_t<indices>::flightInvariant...};
+	static constexpr std::array<bool, descriptorSetCount> setsPushDescriptor = {descriptorSet_t<indices>::pushDescriptor...};
+	static constexpr uint32_t allocatedSetCount = (0 + ... + (descriptorSet_t<indices>::pushDescriptor ? 0 : uint32_t(descriptorSet_t<indices>::flightCopies)));
+	static constexpr std::array<uint32_t, descriptorSetCount> setsVariableDescriptorCount = {descriptorSet_t<indices>::variableDescriptorCount...};
+	static constexpr bool updateAfterBind = (descriptorSet_t<indices>::updateAfterBind || ...);
+	static constexpr bool variableDescriptorCounts = ((descriptorSet_t<indices>::variableDescriptorCount > 0) || ...);
+	// if any set can't live in a descriptor buffer, none do, as a pipeline can't mix the two
+	static constexpr bool descriptorBufferCompatible = (descriptorSet_t<indices>::descriptorBufferCompatible && ...);
+	
+	template <typename uniformWithShaderStage_t>
+	static consteval VkDescriptorPoolSize PoolSize(){
+		VkDescriptorPoolSize ret = descriptor_t<uniformWithShaderStage_t>::poolSize;
+		// descriptors' pool sizes provide for a set per flight
+		if constexpr (descriptorSet_t<uniformWithShaderStage_t::type::setValue>::flightInvariant){
+			ret.descriptorCount /= MAX_FRAMES_IN_FLIGHT;
+		}
+		return ret;
+	}
+	
+	// uniforms in push descriptor sets take no space in the pool
+	template <typename uniformWithShaderStage_t>
+	static constexpr bool pushedUniform = descriptorSet_t<uniformWithShaderStage_t::type::setValue>::pushDescriptor;
+	static constexpr uint32_t pooledUniformCount = (0 + ... + (pushedUniform<uniformWithShaderStage_ts> ? 0 : 1));
+	
+	static consteval std::array<VkDescriptorPoolSize, pooledUniformCount> PoolSizes(){
+		if constexpr (pooledUniformCount == 0){
 			return {{}};
 		} else {
-			std::array<VkDescriptorPoolSize, uniformCount> ret;
+			std::array<VkDescriptorPoolSize, pooledUniformCount> ret;
 			size_t i = 0;
-			(void(ret[i++] = descriptor_t<uniformWithShaderStage_ts>::poolSize), ...);
+			([&](){
+				if constexpr (!pushedUniform<uniformWithShaderStage_ts>){
+					ret[i++] = PoolSize<uniformWithShaderStage_ts>();
+				}
+			}(), ...);
 			return ret;
 		}
 	}
 	
+	// whether none of the sets in a range are push descriptor sets, so they can be bound
+	template <uint32_t first, uint32_t number>
+	static consteval bool SetsAllocated(){
+		for(uint32_t i=first; i<first + number; ++i){
+			if(setsPushDescriptor[i]){
+				return false;
+			}
+		}
+		return true;
+	}
+	
 //	template <uint32_t index>
 //	descriptorSet_t<index> &iDescriptorSet(){ return std::get<index>(descriptorSets); }
 	
@@ -482,63 +930,146 @@ public:
 			(void(std::get<indices>(descriptorSets) = descriptorSet_t<indices>(_devices)), ...);
 		}
 		
-		std::array<VkDescriptorPoolSize, uniformCount> poolSizes = PoolSizes();
-		
-		// descriptor pool
-		const VkDescriptorPoolCreateInfo poolInfo{
-			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-//			.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
-			.poolSizeCount = uniformCount,
-			.pPoolSizes = poolSizes.data(),
-			.maxSets = uint32_t(MAX_FRAMES_IN_FLIGHT * descriptorSetCount)
-		};
-		if(vkCreateDescriptorPool(_devices->GetLogicalDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS){
-			throw std::runtime_error("failed to create descriptor pool!");
-		}
+		descriptorBuffers = _devices->UsesDescriptorBuffers() && descriptorBufferCompatible;
 		
 		// descriptor set layouts
+		std::array<VkDeviceSize, descriptorSetCount> descriptorBufferSizes {};
 		([&](){
-			descriptorSetLayouts[indices] = std::get<indices>(descriptorSets).CreateLayout();
+			descriptorSetLayouts[indices] = std::get<indices>(descriptorSets).CachedLayout(descriptorBuffers);
+			if(descriptorBuffers){
+				descriptorBufferSizes[indices] = std::get<indices>(descriptorSets).InitDescriptorBuffer(descriptorSetLayouts[indices]);
+			} else {
+				std::get<indices>(descriptorSets).CreateUpdateTemplates(descriptorSetLayouts[indices]);
+			}
 		}(), ...);
 		
-		// allocating descriptor sets
-		VkDescriptorSetLayout flyingLayouts[descriptorSetCount * MAX_FRAMES_IN_FLIGHT];
+		// allocating descriptor sets; flight-invariant sets are allocated once, and every flight refers to the same one, while push descriptor sets are not allocated at all
+		constexpr uint32_t noAllocation = UINT32_MAX;
+		std::array<VkDescriptorSetLayout, allocatedSetCount> allocatedLayouts;
+		std::array<uint32_t, allocatedSetCount> allocatedVariableCounts;
+		std::array<uint32_t, descriptorSetCount * MAX_FRAMES_IN_FLIGHT> allocatedIndices;
+		// with descriptor buffers, each allocated set is part of one region of `Devices`' descriptor buffer instead
+		std::array<VkDeviceSize, allocatedSetCount> allocatedOffsets;
+		VkDeviceSize descriptorBufferSize = 0;
+		uint32_t allocatedCounter = 0;
 		for(int i=0; i<MAX_FRAMES_IN_FLIGHT; ++i){
 			for(int j=0; j<descriptorSetCount; ++j){
-				flyingLayouts[descriptorSetCount * i + j] = descriptorSetLayouts[j];
+				if(setsPushDescriptor[j]){
+					allocatedIndices[descriptorSetCount * i + j] = noAllocation;
+					continue;
+				}
+				if(i > 0 && setsFlightInvariant[j]){
+					allocatedIndices[descriptorSetCount * i + j] = allocatedIndices[j];
+					continue;
+				}
+				allocatedIndices[descriptorSetCount * i + j] = allocatedCounter;
+				allocatedVariableCounts[allocatedCounter] = setsVariableDescriptorCount[j];
+				allocatedOffsets[allocatedCounter] = descriptorBufferSize;
+				if(descriptorBuffers){
+					const VkDeviceSize alignment = _devices->DescriptorBufferProperties().descriptorBufferOffsetAlignment;
+					descriptorBufferSize += (descriptorBufferSizes[j] + alignment - 1) / alignment * alignment;
+				}
+				allocatedLayouts[allocatedCounter++] = descriptorSetLayouts[j];
 			}
 		}
-		const VkDescriptorSetAllocateInfo allocInfo{
-			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-			.descriptorPool = descriptorPool,
-			.descriptorSetCount = descriptorSetCount * MAX_FRAMES_IN_FLIGHT,
-			.pSetLayouts = flyingLayouts
-		};
-		if(vkAllocateDescriptorSets(_devices->GetLogicalDevice(), &allocInfo, descriptorSetsFlying.data()) != VK_SUCCESS){
-			throw std::runtime_error("failed to allocate descriptor sets!");
+		
+		// with only push descriptor sets there is nothing to allocate, and `descriptorPool` stays null
+		if constexpr (allocatedSetCount > 0){
+			if(descriptorBuffers){
+				const std::optional<Devices::DescriptorBufferRegion> region = _devices->AllocateDescriptorBufferRegion(descriptorBufferSize);
+				if(!region){
+					throw std::runtime_error("failed to allocate descriptor buffer region!");
+				}
+				descriptorBufferRegion = region.value();
+				for(size_t i=0; i<descriptorBufferOffsetsFlying.size(); ++i){
+					descriptorBufferOffsetsFlying[i] = allocatedIndices[i] == noAllocation ? 0 : descriptorBufferRegion.offset + allocatedOffsets[allocatedIndices[i]];
+				}
+				return;
+			}
+			
+			std::array<VkDescriptorPoolSize, pooledUniformCount> poolSizes = PoolSizes();
+			
+			// descriptor pool
+			const VkDescriptorPoolCreateInfo poolInfo{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+				.flags = updateAfterBind ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : VkDescriptorPoolCreateFlags(0),
+				.poolSizeCount = pooledUniformCount,
+				.pPoolSizes = poolSizes.data(),
+				.maxSets = allocatedSetCount
+			};
+			if(vkCreateDescriptorPool(_devices->GetLogicalDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS){
+				throw std::runtime_error("failed to create descriptor pool!");
+			}
+			
+			// variable-count bindings are allocated at their full capacity
+			const VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+				.descriptorSetCount = allocatedSetCount,
+				.pDescriptorCounts = allocatedVariableCounts.data()
+			};
+			const VkDescriptorSetAllocateInfo allocInfo{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				.pNext = variableDescriptorCounts ? &variableCountInfo : nullptr,
+				.descriptorPool = descriptorPool,
+				.descriptorSetCount = allocatedSetCount,
+				.pSetLayouts = allocatedLayouts.data()
+			};
+			std::array<VkDescriptorSet, allocatedSetCount> allocatedSets;
+			if(vkAllocateDescriptorSets(_devices->GetLogicalDevice(), &allocInfo, allocatedSets.data()) != VK_SUCCESS){
+				throw std::runtime_error("failed to allocate descriptor sets!");
+			}
+			for(size_t i=0; i<descriptorSetsFlying.size(); ++i){
+				descriptorSetsFlying[i] = allocatedIndices[i] == noAllocation ? VK_NULL_HANDLE : allocatedSets[allocatedIndices[i]];
+			}
 		}
 	}
 	~UniformsImpl(){
-		vkDestroyDescriptorPool(devices->GetLogicalDevice(), descriptorPool, nullptr);
-		for(VkDescriptorSetLayout &dsl : descriptorSetLayouts){
-			vkDestroyDescriptorSetLayout(devices->GetLogicalDevice(), dsl, nullptr);
+		(void(std::get<indices>(descriptorSets).DestroyUpdateTemplates()), ...);
+		if constexpr (allocatedSetCount > 0){
+			if(descriptorBuffers){
+				devices->FreeDescriptorBufferRegion(descriptorBufferRegion);
+			}
+			vkDestroyDescriptorPool(devices->GetLogicalDevice(), descriptorPool, nullptr);
 		}
 	}
 	
-	// have to do this every time any elements of any descriptors are changed, e.g. when an image view is re-created upon window resize
+	// have to do this every time any elements of any descriptors are changed, e.g. when an image view is re-created upon window resize; only `flight`'s copies of the sets, and only their changed descriptors, are written
 	template <uint32_t first, uint32_t number>
 	requires (first + number <= descriptorSetCount)
-	bool UpdateDescriptorSets(){
-		if(CheckDescriptorSetsValid<first, number>()){
+	bool UpdateDescriptorSets(uint32_t flight){
+		if(CheckDescriptorSetsValid<first, number>(flight)){
 			return true;
 		}
 		return [&]<uint32_t... indexSubset>(std::integer_sequence<uint32_t, indexSubset...>) -> bool {
-			return (std::get<indexSubset + first>(descriptorSets).Update([&](uint32_t flight) -> const VkDescriptorSet & {
-				return descriptorSetsFlying[descriptorSetCount * flight + indexSubset + first];
-			}) && ...);
+			return (std::get<indexSubset + first>(descriptorSets).Update(flight, descriptorSetsFlying[descriptorSetCount * flight + indexSubset + first], descriptorBuffers ? devices->DescriptorBufferData(descriptorBufferOffsetsFlying[descriptorSetCount * flight + indexSubset + first]) : nullptr) && ...);
 		}(std::make_integer_sequence<uint32_t, number>{});
 	}
 	
+	// whether the descriptors live in a descriptor buffer (see `Devices::UsesDescriptorBuffers`) rather than allocated descriptor sets
+	bool UsesDescriptorBuffers() const { return descriptorBuffers; }
+	VkPipelineCreateFlags PipelineCreateFlags() const {
+		return descriptorBuffers ? VkPipelineCreateFlags(VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT) : VkPipelineCreateFlags(0);
+	}
+	
+	// Points sets [`first`, `first + number`) at `flight`'s parts of the uniforms' region of the descriptor buffer, which must already be bound (see `Devices::CmdBindDescriptorBuffer`)
+	template <uint32_t first, uint32_t number>
+	requires (first + number <= descriptorSetCount)
+	void CmdSetDescriptorBufferOffsets(VkCommandBuffer commandBuffer, uint32_t flight, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const {
+		const std::array<uint32_t, number> bufferIndices {};
+		std::array<VkDeviceSize, number> offsets;
+		for(uint32_t i=0; i<number; ++i){
+			offsets[i] = descriptorBufferOffsetsFlying[descriptorSetCount * flight + first + i];
+		}
+		devices->CmdSetDescriptorBufferOffsets(commandBuffer, bindPoint, layout, first, number, bufferIndices.data(), offsets.data());
+	}
+	
+	// Records the descriptors of push descriptor set `set`
+	template <uint32_t set>
+	requires (set < descriptorSetCount && setsPushDescriptor[set])
+	bool CmdPushDescriptorSet(VkCommandBuffer commandBuffer, uint32_t flight, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const {
+		return std::get<set>(descriptorSets).CmdPush(commandBuffer, flight, bindPoint, layout, set);
+	}
+	
 	const std::array<VkDescriptorSetLayout, descriptorSetCount> &DescriptorSetLayouts() const {
 		return descriptorSetLayouts;
 	}
@@ -547,20 +1078,30 @@ public:
 		return &descriptorSetsFlying[flight * descriptorSetCount];
 	}
 	
+	// the number of dynamic offset numbers that binding sets [`first`, `first + number`) takes, one per dynamic UBO or SBO in binding order, and a typed list of them
+	template <uint32_t first, uint32_t number>
+	static constexpr uint32_t dynamicOffsetNumberCount = []<uint32_t... indexSubset>(std::integer_sequence<uint32_t, indexSubset...>){
+		return (0 + ... + descriptorSet_t<indexSubset + first>::dynamicOffsetNumberCount);
+	}(std::make_integer_sequence<uint32_t, number>{});
+	template <uint32_t first, uint32_t number>
+	using dynamicOffsetNumbers_t = std::array<uint32_t, dynamicOffsetNumberCount<first, number>>;
+	
+	// the number of dynamic offsets that binding sets [`first`, `first + number`) passes, one per dynamic descriptor; known here so they needn't be allocated per bind
 	template <uint32_t first, uint32_t number>
+	static constexpr uint32_t dynamicOffsetCount = []<uint32_t... indexSubset>(std::integer_sequence<uint32_t, indexSubset...>){
+		return (0 + ... + descriptorSet_t<indexSubset + first>::dynamicOffsetCount);
+	}(std::make_integer_sequence<uint32_t, number>{});
+	
+	template <uint32_t first, uint32_t number, typename numbers_t>
 	requires (first + number <= descriptorSetCount)
-	std::vector<uint32_t> GetDynamicOffsets(const std::vector<int> &dynamicOffsetNumbers) const {
-		std::vector<uint32_t> ret {};
+	std::array<uint32_t, dynamicOffsetCount<first, number>> GetDynamicOffsets(uint32_t flight, const numbers_t &dynamicOffsetNumbers) const {
+		std::array<uint32_t, dynamicOffsetCount<first, number>> ret {};
 		int indexOfDynamic = 0;
+		uint32_t *next = ret.data();
 		[&]<uint32_t... indexSubset>(std::integer_sequence<uint32_t, indexSubset...>){
-			([&](){
-				const std::optional<VkDeviceSize> dynamicAlignment = std::get<indexSubset + first>(descriptorSets).GetUBODynamicAlignment();
-				if(dynamicAlignment){
-					ret.push_back(uint32_t(dynamicOffsetNumbers[indexOfDynamic++] * dynamicAlignment.value()));
-				}
-			}(), ...);
+			(void(std::get<indexSubset + first>(descriptorSets).WriteDynamicOffsets(flight, dynamicOffsetNumbers, indexOfDynamic, next)), ...);
 		}(std::make_integer_sequence<uint32_t, number>{});
-//		assert(ret.size() == dynamicOffsetNumbers.size());
+		assert(indexOfDynamic == int(std::size(dynamicOffsetNumbers)));
 		return ret;
 	}
 	
@@ -569,6 +1110,22 @@ public:
 		return std::get<index>(descriptorSets);
 	}
 	
+	// whether sets of `otherDescriptorSet_t` can be bound in place of set `set`
+	template <uint32_t set, typename otherDescriptorSet_t>
+	static consteval bool DescriptorSetCompatible(){
+		if constexpr (set >= descriptorSetCount){
+			return false;
+		} else {
+			return descriptorSet_t<set>::template IdenticallyDefined<otherDescriptorSet_t>();
+		}
+	}
+	
+	// whether a `SharedDescriptorSet` can be bound in place of the set at its index
+	template <typename sharedDescriptorSet_t>
+	static consteval bool SharedSetCompatible(){
+		return DescriptorSetCompatible<sharedDescriptorSet_t::setValue, typename sharedDescriptorSet_t::descriptorSet_t>();
+	}
+	
 	VkDescriptorPool GetVkDescriptorPool() const { return descriptorPool; }
 	
 private:
@@ -578,13 +1135,17 @@ private:
 	
 	std::array<VkDescriptorSetLayout, descriptorSetCount> descriptorSetLayouts {};
 	std::array<VkDescriptorSet, descriptorSetCount * MAX_FRAMES_IN_FLIGHT> descriptorSetsFlying {};
-	VkDescriptorPool descriptorPool;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	
+	bool descriptorBuffers = false;
+	Devices::DescriptorBufferRegion descriptorBufferRegion {};
+	std::array<VkDeviceSize, descriptorSetCount * MAX_FRAMES_IN_FLIGHT> descriptorBufferOffsetsFlying {};
 	
 	template <uint32_t first, uint32_t number>
 	requires (first + number <= descriptorSetCount)
-	bool CheckDescriptorSetsValid() const {
+	bool CheckDescriptorSetsValid(uint32_t flight) const {
 		return [&]<uint32_t... indexSubset>(std::integer_sequence<uint32_t, indexSubset...>) -> bool {
-			return (std::get<indexSubset + first>(descriptorSets).CheckDescriptorsValid() && ...);
+			return (std::get<indexSubset + first>(descriptorSets).CheckDescriptorsValid(flight, descriptorBuffers) && ...);
 		}(std::make_integer_sequence<uint32_t, number>{});
 	}
 };
@@ -597,6 +1158,167 @@ template <typename uniformWithShaderStage_tp>
 using Uniforms = typename UniformsStruct<uniformWithShaderStage_tp>::type;
 
 
+// Shared descriptor sets
+// -----
+/*
+ A descriptor set owned outside of any pipeline, e.g. camera and lighting data at set 0, so its descriptors are set and written once rather than in every pipeline that uses them.
+ The uniforms are given with the stages that use them, as `WithShaderStage<stageFlags, uniform_t>`; these must match the merged stages of the pipelines it is bound with, as the layouts have to be identically defined. This is checked when binding it with a pipeline (see e.g. `RenderPipeline::CmdBindSharedDescriptorSet`).
+ Once bound, the set stays bound across pipeline changes, as long as the pipelines' layouts are compatible for it: they have the same push constant ranges, and identically defined layouts for it and every lower set.
+ If `Devices` uses descriptor buffers and the set can live in one, it also has a region of `Devices`' descriptor buffer, from which it is bound with pipelines that use descriptor buffers; pipelines that don't still bind its descriptor sets.
+ */
+template <uint32_t set, typename... uniformWithShaderStage_ts>
+requires ((uniformWithShaderStage_c<uniformWithShaderStage_ts> && ...))
+class SharedDescriptorSet {
+public:
+	static_assert(sizeof...(uniformWithShaderStage_ts) > 0, "A shared descriptor set should have at least one uniform.");
+	static_assert(((uniformWithShaderStage_ts::type::setValue == set) && ...), "Every uniform in a shared descriptor set should have the set's index.");
+	static_assert(UniformsUnique<uniformWithShaderStage_ts...>(), "No two uniforms should have both matching set and binding.");
+	
+	static constexpr uint32_t setValue = set;
+	
+	using descriptorSet_t = DescriptorSet<filteredDescriptorPack_t<set, uniformWithShaderStage_ts...>>;
+	
+	static_assert(!descriptorSet_t::pushDescriptor, "Push descriptor sets cannot be shared; they are recorded into each command buffer.");
+	
+	static constexpr bool flightInvariant = descriptorSet_t::flightInvariant;
+	static constexpr uint32_t flightCopies = descriptorSet_t::flightCopies;
+	
+	template <uint32_t binding>
+	using descriptor_t = typename descriptorSet_t::template descriptor_t<binding>;
+	
+	explicit SharedDescriptorSet(std::shared_ptr<Devices> _devices)
+	: devices(_devices), descriptorSet(_devices) {
+		layout = descriptorSet.CachedLayout();
+		descriptorSet.CreateUpdateTemplates(layout);
+		
+		// a copy of the set per flight in the descriptor buffer, each aligned for binding
+		if constexpr (descriptorSet_t::descriptorBufferCompatible){
+			if(_devices->UsesDescriptorBuffers()){
+				const VkDeviceSize alignment = _devices->DescriptorBufferProperties().descriptorBufferOffsetAlignment;
+				descriptorBufferStride = (descriptorSet.InitDescriptorBuffer(descriptorSet.CachedLayout(true)) + alignment - 1) / alignment * alignment;
+				descriptorBufferRegion = _devices->AllocateDescriptorBufferRegion(flightCopies * descriptorBufferStride);
+				if(!descriptorBufferRegion){
+					throw std::runtime_error("failed to allocate descriptor buffer region!");
+				}
+			}
+		}
+		
+		// descriptors' pool sizes provide for a set per flight
+		std::array<VkDescriptorPoolSize, sizeof...(uniformWithShaderStage_ts)> poolSizes = {EVK::descriptor_t<uniformWithShaderStage_ts>::poolSize...};
+		if constexpr (flightInvariant){
+			for(VkDescriptorPoolSize &poolSize : poolSizes){
+				poolSize.descriptorCount /= MAX_FRAMES_IN_FLIGHT;
+			}
+		}
+		const VkDescriptorPoolCreateInfo poolInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = descriptorSet_t::updateAfterBind ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : VkDescriptorPoolCreateFlags(0),
+			.poolSizeCount = uint32_t(poolSizes.size()),
+			.pPoolSizes = poolSizes.data(),
+			.maxSets = flightCopies
+		};
+		if(vkCreateDescriptorPool(_devices->GetLogicalDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS){
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+		
+		std::array<VkDescriptorSetLayout, flightCopies> layouts;
+		std::array<uint32_t, flightCopies> variableCounts;
+		layouts.fill(layout);
+		variableCounts.fill(descriptorSet_t::variableDescriptorCount);
+		const VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+			.descriptorSetCount = flightCopies,
+			.pDescriptorCounts = variableCounts.data()
+		};
+		const VkDescriptorSetAllocateInfo allocInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = descriptorSet_t::variableDescriptorCount > 0 ? &variableCountInfo : nullptr,
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = flightCopies,
+			.pSetLayouts = layouts.data()
+		};
+		if(vkAllocateDescriptorSets(_devices->GetLogicalDevice(), &allocInfo, descriptorSets.data()) != VK_SUCCESS){
+			throw std::runtime_error("failed to allocate descriptor sets!");
+		}
+	}
+	~SharedDescriptorSet(){
+		descriptorSet.DestroyUpdateTemplates();
+		if(descriptorBufferRegion){
+			devices->FreeDescriptorBufferRegion(descriptorBufferRegion.value());
+		}
+		vkDestroyDescriptorPool(devices->GetLogicalDevice(), descriptorPool, nullptr);
+	}
+	
+	SharedDescriptorSet(const SharedDescriptorSet &) = delete;
+	SharedDescriptorSet &operator=(const SharedDescriptorSet &) = delete;
+	
+	template <uint32_t binding>
+	descriptor_t<binding> &iDescriptor(){
+		return descriptorSet.template iDescriptor<binding>();
+	}
+	
+	// Writes the descriptors that have changed to `flight`'s copy of the set, or to its copy in the descriptor buffer if `descriptorBuffer`. Returns false if any cannot be written yet.
+	[[nodiscard]]
+	bool Update(uint32_t flight, bool descriptorBuffer=false){
+		if(descriptorBuffer && !descriptorBufferRegion){
+			std::cout << "Cannot update shared descriptor set; it has no descriptor buffer region.\n";
+			return false;
+		}
+		if(descriptorSet.CheckDescriptorsValid(flight, descriptorBuffer)){
+			return true;
+		}
+		return descriptorSet.Update(flight, Handle(flight), descriptorBuffer ? devices->DescriptorBufferData(DescriptorBufferOffset(flight)) : nullptr);
+	}
+	
+	// Updates and binds `flight`'s copy of the set at index `set` of `pipelineLayout`, with dynamic offsets as for the pipelines' `CmdBindDescriptorSets`. If `descriptorBuffer`, the pipeline uses descriptor buffers, so the set is bound from its copy in the descriptor buffer, which must already be bound (see `Devices::CmdBindDescriptorBuffer`).
+	template <typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBind(VkCommandBuffer commandBuffer, uint32_t flight, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, bool descriptorBuffer, const numbers_t &dynamicOffsetNumbers=numbers_t()){
+		if(!DynamicOffsetNumbersMatch<descriptorSet_t::dynamicOffsetNumberCount>(dynamicOffsetNumbers)){
+			return false;
+		}
+		if(!Update(flight, descriptorBuffer)){
+			return false;
+		}
+		if(descriptorBuffer){
+			// sets in descriptor buffers have no dynamic offsets
+			const uint32_t bufferIndex = 0;
+			const VkDeviceSize offset = DescriptorBufferOffset(flight);
+			devices->CmdSetDescriptorBufferOffsets(commandBuffer, bindPoint, pipelineLayout, set, 1, &bufferIndex, &offset);
+			return true;
+		}
+		std::array<uint32_t, descriptorSet_t::dynamicOffsetCount> dynamicOffsets {};
+		int indexOfDynamic = 0;
+		uint32_t *next = dynamicOffsets.data();
+		descriptorSet.WriteDynamicOffsets(flight, dynamicOffsetNumbers, indexOfDynamic, next);
+		assert(indexOfDynamic == int(std::size(dynamicOffsetNumbers)));
+		const VkDescriptorSet handle = Handle(flight);
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, set, 1, &handle, uint32_t(dynamicOffsets.size()), dynamicOffsets.empty() ? nullptr : dynamicOffsets.data());
+		return true;
+	}
+	
+	[[nodiscard]] VkDescriptorSet Handle(uint32_t flight) const { return descriptorSets[flightInvariant ? 0 : flight]; }
+	// the layout of the descriptor sets; the copies in the descriptor buffer use the equivalent layout created for descriptor buffers
+	[[nodiscard]] VkDescriptorSetLayout Layout() const { return layout; }
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	descriptorSet_t descriptorSet;
+	
+	VkDescriptorSetLayout layout;
+	VkDescriptorPool descriptorPool;
+	std::array<VkDescriptorSet, flightCopies> descriptorSets;
+	
+	std::optional<Devices::DescriptorBufferRegion> descriptorBufferRegion {};
+	VkDeviceSize descriptorBufferStride = 0;
+	
+	VkDeviceSize DescriptorBufferOffset(uint32_t flight) const {
+		return descriptorBufferRegion->offset + (flightInvariant ? 0 : flight) * descriptorBufferStride;
+	}
+};
+
+
 // Shader
 // -----
 template <VkShaderStageFlags shaderStage, const char *filename, typename pushConstants_t, typename... uniform_ts>
@@ -611,6 +1333,7 @@ struct Shader {
 	using uniformWithShaderStage_tp = TypePack<WithShaderStage<shaderStage, uniform_ts>...>;
 	
 	static constexpr std::string_view filenameValue = {filename};
+	static constexpr VkShaderStageFlags shaderStageValue = shaderStage;
 };
 
 template <typename T>
@@ -624,6 +1347,8 @@ template <const char *filename, typename pushConstants_t, typename attributes_t,
 struct VertexShader
 : public Shader<VK_SHADER_STAGE_VERTEX_BIT, filename, pushConstants_t, uniform_ts...> {
 	
+	using vertexAttributes_t = attributes_t;
+	
 //	static constexpr const VkPipelineVertexInputStateCreateInfo *const pipelineVertexInputStateCI = &attributes_t::pipelineVertexInputStateCI;
 	static PipelineVertexInputStateCreateInfoSafe PipelineVertexInputStateCI(){ return attributes_t::PipelineVertexInputStateCI(); }
 };
@@ -635,6 +1360,18 @@ concept vertexShader_c = requires (T val) {
 	{T::PipelineVertexInputStateCI()} -> std::same_as<PipelineVertexInputStateCreateInfoSafe>;
 };
 
+// For a `MeshPipeline` without a task shader
+struct NoTaskShader {
+	using pushConstantWithShaderStage_tp = TypePack<>;
+	using uniformWithShaderStage_tp = TypePack<>;
+};
+
+template <typename T>
+concept taskShader_c = std::same_as<T, NoTaskShader> || (shader_c<T> && T::shaderStageValue == VK_SHADER_STAGE_TASK_BIT_EXT);
+
+template <typename T>
+concept meshShader_c = shader_c<T> && T::shaderStageValue == VK_SHADER_STAGE_MESH_BIT_EXT;
+
 // Pipeline
 // -----
 template <typename pushConstantWithShaderStages_tp> struct PushConstantManager;
@@ -690,9 +1427,7 @@ public:
 			.pushConstantRangeCount = pushConstantManager_t::pushConstantCount,
 			.pPushConstantRanges = pushConstantManager_t::pushConstantCount == 0 ? nullptr : pcrs.data()
 		};
-		if(vkCreatePipelineLayout(_devices->GetLogicalDevice(), &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS){
-			throw std::runtime_error("Failed to create pipeline layout!");
-		}
+		layout = _devices->CachedPipelineLayout(pipelineLayoutInfo);
 		
 		// ----- Input assembly info -----
 		const VkPipelineInputAssemblyStateCreateInfo inputAssembly {
@@ -740,6 +1475,7 @@ public:
 		// Pipeline
 		const VkGraphicsPipelineCreateInfo pipelineInfo {
 			 .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+			 .flags = uniforms.PipelineCreateFlags(),
 			 .stageCount = 2,
 			 .pStages = stageCIs,
 			 .pVertexInputState = &pvisci,//vertexShader_t::pipelineVertexInputStateCI,
@@ -762,7 +1498,6 @@ public:
 	}
 	~RenderPipeline(){
 		vkDestroyPipeline(devices->GetLogicalDevice(), pipeline, nullptr);
-		vkDestroyPipelineLayout(devices->GetLogicalDevice(), layout, nullptr);
 //		vkDestroyShaderModule(devices->GetLogicalDevice(), fragShaderModule, nullptr);
 //		vkDestroyShaderModule(devices->GetLogicalDevice(), vertShaderModule, nullptr);
 	}
@@ -772,26 +1507,91 @@ public:
 		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
 	}
 	
-	// Set which descriptor sets are bound for subsequent render calls
+	// A typed list of the dynamic offset numbers for binding sets [`first`, `first + number`), one per dynamic UBO or SBO in binding order
 	template <uint32_t first=0, uint32_t number=0>
+	using dynamicOffsetNumbers_t = typename uniforms_t::template dynamicOffsetNumbers_t<first, (number < 1 ? descriptorSetCount - first : number)>;
+	
+	// Set which descriptor sets are bound for subsequent render calls. `dynamicOffsetNumbers` can be a `dynamicOffsetNumbers_t`, whose size is checked at compile time, or a `std::span` over the caller's storage, so binding needn't allocate; binding fails if a runtime-sized list has the wrong number of numbers.
+	template <uint32_t first=0, uint32_t number=0, typename numbers_t=std::vector<int>>
 	[[nodiscard]]
-	bool CmdBindDescriptorSets(const CommandEnvironment &commandEnvironment, const std::vector<int> &dynamicOffsetNumbers=std::vector<int>()) {
+	bool CmdBindDescriptorSets(const CommandEnvironment &commandEnvironment, const numbers_t &dynamicOffsetNumbers=numbers_t()) {
 		constexpr uint32_t numberUse = number < 1 ? descriptorSetCount - first : number;
 		
+		if(!DynamicOffsetNumbersMatch<uniforms_t::template dynamicOffsetNumberCount<first, numberUse>>(dynamicOffsetNumbers)){
+			return false;
+		}
+		
+		static_assert(uniforms_t::template SetsAllocated<first, numberUse>(), "Push descriptor sets are not bound; record them with `CmdPushDescriptors`.");
+		
 		// making sure all descriptor sets are valid
-		if(!uniforms.template UpdateDescriptorSets<first, numberUse>()){
+		if(!uniforms.template UpdateDescriptorSets<first, numberUse>(commandEnvironment.flight)){
 			return false;
 		}
 		
-		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(commandEnvironment.flight);
+		if(uniforms.UsesDescriptorBuffers()){
+			uniforms.template CmdSetDescriptorBufferOffsets<first, numberUse>(commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout);
+			return true;
+		}
+		
+		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(commandEnvironment.flight) + first;
 		
-		// binding, optionally using dynamic offsets
-		if(dynamicOffsetNumbers.empty()){
-			vkCmdBindDescriptorSets(commandEnvironment.commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, 0, nullptr);
-		} else {
-			const std::vector<uint32_t> dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(dynamicOffsetNumbers);
-			vkCmdBindDescriptorSets(commandEnvironment.commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+		// binding, with dynamic offsets for any dynamic or packed buffers
+		const auto dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(commandEnvironment.flight, dynamicOffsetNumbers);
+		vkCmdBindDescriptorSets(commandEnvironment.commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.empty() ? nullptr : dynamicOffsets.data());
+		return true;
+	}
+	
+	// Record the descriptors of push descriptor set `set` (see `PushedUniform`) for subsequent render calls; they can be changed and pushed again between draws
+	template <uint32_t set>
+	[[nodiscard]]
+	bool CmdPushDescriptors(const CommandEnvironment &commandEnvironment) const {
+		return uniforms.template CmdPushDescriptorSet<set>(commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout);
+	}
+	
+	// Bind a `SharedDescriptorSet` at its set index, in place of this pipeline's own set there. It stays bound for subsequent pipelines whose layouts are compatible for it, so needn't be bound again after switching between them.
+	template <typename sharedDescriptorSet_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindSharedDescriptorSet(const CommandEnvironment &commandEnvironment, sharedDescriptorSet_t &sharedDescriptorSet, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template SharedSetCompatible<sharedDescriptorSet_t>(), "The shared descriptor set's layout should be identically defined to the pipeline's at its set index.");
+		return sharedDescriptorSet.CmdBind(commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Bind instance `id` of a `DescriptorSetAllocator` at set `set`, in place of this pipeline's own set there, e.g. to switch materials between draws
+	template <uint32_t set, typename descriptorSetAllocator_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindDescriptorSetInstance(const CommandEnvironment &commandEnvironment, descriptorSetAllocator_t &allocator, typename descriptorSetAllocator_t::InstanceID id, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template DescriptorSetCompatible<set, typename descriptorSetAllocator_t::descriptorSet_t>(), "The allocator's descriptor set layout should be identically defined to the pipeline's at the set index.");
+		return allocator.CmdBind(id, commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout, set, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Draw with `drawCount` `VkDrawIndexedIndirectCommand`s read from `drawCommands`, starting at `offset` into the flight's copy
+	void CmdDrawIndexedIndirect(const CommandEnvironment &commandEnvironment, const StorageBufferObject &drawCommands, uint32_t drawCount, VkDeviceSize offset=0) const {
+		const VkBuffer buffer = drawCommands.BufferFlying(commandEnvironment.flight);
+		offset += commandEnvironment.flight * drawCommands.FlightStride();
+		if(drawCount <= 1 || devices->GetFeatures().multiDrawIndirect){
+			vkCmdDrawIndexedIndirect(commandEnvironment.commandBuffer, buffer, offset, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+			return;
 		}
+		// without multi-draw indirect, each draw is its own command
+		for(uint32_t i=0; i<drawCount; ++i){
+			vkCmdDrawIndexedIndirect(commandEnvironment.commandBuffer, buffer, offset + i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+	
+	// Draw with as many `VkDrawIndexedIndirectCommand`s from `drawCommands` as the `uint32_t` at `countOffset` in `drawCount` says, up to `maxDrawCount`. Requires `drawIndirectCount` (see `Devices::GetVulkan12Features`).
+	[[nodiscard]]
+	bool CmdDrawIndexedIndirectCount(const CommandEnvironment &commandEnvironment, const StorageBufferObject &drawCommands, const StorageBufferObject &drawCount, uint32_t maxDrawCount, VkDeviceSize offset=0, VkDeviceSize countOffset=0) const {
+		if(!devices->GetVulkan12Features().drawIndirectCount){
+			std::cout << "Cannot draw indexed indirect count; drawIndirectCount is not supported.\n";
+			return false;
+		}
+		vkCmdDrawIndexedIndirectCount(commandEnvironment.commandBuffer,
+									  drawCommands.BufferFlying(commandEnvironment.flight),
+									  offset + commandEnvironment.flight * drawCommands.FlightStride(),
+									  drawCount.BufferFlying(commandEnvironment.flight),
+									  countOffset + commandEnvironment.flight * drawCount.FlightStride(),
+									  maxDrawCount,
+									  sizeof(VkDrawIndexedIndirectCommand));
 		return true;
 	}
 	
@@ -827,6 +1627,7 @@ protected:
 	
 	uniforms_t uniforms;
 	
+	// from `Devices`' layout cache, which owns it
 	VkPipelineLayout layout;
 	
 	VkPipeline pipeline;
@@ -857,9 +1658,7 @@ public:
 			.pushConstantRangeCount = pushConstantManager_t::pushConstantCount,
 			.pPushConstantRanges = pushConstantManager_t::pushConstantCount == 0 ? nullptr : pcrs.data()
 		};
-		if(vkCreatePipelineLayout(_devices->GetLogicalDevice(), &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS){
-			throw std::runtime_error("Failed to create pipeline layout!");
-		}
+		layout = _devices->CachedPipelineLayout(pipelineLayoutInfo);
 		
 		// ----- Input assembly info -----
 		const VkPipelineInputAssemblyStateCreateInfo inputAssembly {
@@ -897,6 +1696,7 @@ public:
 		// Pipeline
 		const VkGraphicsPipelineCreateInfo pipelineInfo {
 			 .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+			 .flags = uniforms.PipelineCreateFlags(),
 			 .stageCount = 1,
 			 .pStages = &stageCI,
 			 .pVertexInputState = &pvisci,//vertexShader_t::pipelineVertexInputStateCI,
@@ -919,7 +1719,6 @@ public:
 	}
 	~DepthPipeline(){
 		vkDestroyPipeline(devices->GetLogicalDevice(), pipeline, nullptr);
-		vkDestroyPipelineLayout(devices->GetLogicalDevice(), layout, nullptr);
 //		vkDestroyShaderModule(devices->GetLogicalDevice(), fragShaderModule, nullptr);
 //		vkDestroyShaderModule(devices->GetLogicalDevice(), vertShaderModule, nullptr);
 	}
@@ -929,29 +1728,300 @@ public:
 		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
 	}
 	
-	// Set which descriptor sets are bound for subsequent render calls
+	// A typed list of the dynamic offset numbers for binding sets [`first`, `first + number`), one per dynamic UBO or SBO in binding order
 	template <uint32_t first=0, uint32_t number=0>
+	using dynamicOffsetNumbers_t = typename uniforms_t::template dynamicOffsetNumbers_t<first, (number < 1 ? descriptorSetCount - first : number)>;
+	
+	// Set which descriptor sets are bound for subsequent render calls. `dynamicOffsetNumbers` can be a `dynamicOffsetNumbers_t`, whose size is checked at compile time, or a `std::span` over the caller's storage, so binding needn't allocate; binding fails if a runtime-sized list has the wrong number of numbers.
+	template <uint32_t first=0, uint32_t number=0, typename numbers_t=std::vector<int>>
 	[[nodiscard]]
-	bool CmdBindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t flight, const std::vector<int> &dynamicOffsetNumbers=std::vector<int>()) {
+	bool CmdBindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t flight, const numbers_t &dynamicOffsetNumbers=numbers_t()) {
 		constexpr uint32_t numberUse = number < 1 ? descriptorSetCount - first : number;
 		
+		if(!DynamicOffsetNumbersMatch<uniforms_t::template dynamicOffsetNumberCount<first, numberUse>>(dynamicOffsetNumbers)){
+			return false;
+		}
+		
+		static_assert(uniforms_t::template SetsAllocated<first, numberUse>(), "Push descriptor sets are not bound; record them with `CmdPushDescriptors`.");
+		
 		// making sure all descriptor sets are valid
-		if(!uniforms.template UpdateDescriptorSets<first, numberUse>()){
+		if(!uniforms.template UpdateDescriptorSets<first, numberUse>(flight)){
 			return false;
 		}
 		
-		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(flight);
+		if(uniforms.UsesDescriptorBuffers()){
+			uniforms.template CmdSetDescriptorBufferOffsets<first, numberUse>(commandBuffer, flight, bindPoint, layout);
+			return true;
+		}
 		
-		// binding, optionally using dynamic offsets
-		if(dynamicOffsetNumbers.empty()){
-			vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, 0, nullptr);
-		} else {
-			const std::vector<uint32_t> dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(dynamicOffsetNumbers);
-			vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(flight) + first;
+		
+		// binding, with dynamic offsets for any dynamic or packed buffers
+		const auto dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(flight, dynamicOffsetNumbers);
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.empty() ? nullptr : dynamicOffsets.data());
+		return true;
+	}
+	
+	// Record the descriptors of push descriptor set `set` (see `PushedUniform`) for subsequent render calls; they can be changed and pushed again between draws
+	template <uint32_t set>
+	[[nodiscard]]
+	bool CmdPushDescriptors(VkCommandBuffer commandBuffer, uint32_t flight) const {
+		return uniforms.template CmdPushDescriptorSet<set>(commandBuffer, flight, bindPoint, layout);
+	}
+	
+	// Bind a `SharedDescriptorSet` at its set index, in place of this pipeline's own set there. It stays bound for subsequent pipelines whose layouts are compatible for it, so needn't be bound again after switching between them.
+	template <typename sharedDescriptorSet_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindSharedDescriptorSet(VkCommandBuffer commandBuffer, uint32_t flight, sharedDescriptorSet_t &sharedDescriptorSet, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template SharedSetCompatible<sharedDescriptorSet_t>(), "The shared descriptor set's layout should be identically defined to the pipeline's at its set index.");
+		return sharedDescriptorSet.CmdBind(commandBuffer, flight, bindPoint, layout, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Bind instance `id` of a `DescriptorSetAllocator` at set `set`, in place of this pipeline's own set there
+	template <uint32_t set, typename descriptorSetAllocator_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindDescriptorSetInstance(VkCommandBuffer commandBuffer, uint32_t flight, descriptorSetAllocator_t &allocator, typename descriptorSetAllocator_t::InstanceID id, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template DescriptorSetCompatible<set, typename descriptorSetAllocator_t::descriptorSet_t>(), "The allocator's descriptor set layout should be identically defined to the pipeline's at the set index.");
+		return allocator.CmdBind(id, commandBuffer, flight, bindPoint, layout, set, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Draw with `drawCount` `VkDrawIndexedIndirectCommand`s read from `drawCommands`, starting at `offset` into the flight's copy
+	void CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, uint32_t flight, const StorageBufferObject &drawCommands, uint32_t drawCount, VkDeviceSize offset=0) const {
+		const VkBuffer buffer = drawCommands.BufferFlying(flight);
+		offset += flight * drawCommands.FlightStride();
+		if(drawCount <= 1 || devices->GetFeatures().multiDrawIndirect){
+			vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+			return;
+		}
+		// without multi-draw indirect, each draw is its own command
+		for(uint32_t i=0; i<drawCount; ++i){
+			vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset + i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+	
+	// Draw with as many `VkDrawIndexedIndirectCommand`s from `drawCommands` as the `uint32_t` at `countOffset` in `drawCount` says, up to `maxDrawCount`. Requires `drawIndirectCount` (see `Devices::GetVulkan12Features`).
+	[[nodiscard]]
+	bool CmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, uint32_t flight, const StorageBufferObject &drawCommands, const StorageBufferObject &drawCount, uint32_t maxDrawCount, VkDeviceSize offset=0, VkDeviceSize countOffset=0) const {
+		if(!devices->GetVulkan12Features().drawIndirectCount){
+			std::cout << "Cannot draw indexed indirect count; drawIndirectCount is not supported.\n";
+			return false;
+		}
+		vkCmdDrawIndexedIndirectCount(commandBuffer,
+									  drawCommands.BufferFlying(flight),
+									  offset + flight * drawCommands.FlightStride(),
+									  drawCount.BufferFlying(flight),
+									  countOffset + flight * drawCount.FlightStride(),
+									  maxDrawCount,
+									  sizeof(VkDrawIndexedIndirectCommand));
+		return true;
+	}
+	
+	template <uint32_t index>
+	using pushConstantWithShaderStage_t = typename pushConstantManager_t::template pushConstantWithShaderStage_t<index>;
+	
+	template <uint32_t index>
+	using pushConstant_t = typename pushConstantWithShaderStage_t<index>::type;
+	
+	template <uint32_t index>
+	using pushConstantData_t = typename pushConstant_t<index>::type;
+	
+	// Set push constant data
+	template <uint32_t index>
+	void CmdPushConstants(VkCommandBuffer commandBuffer, pushConstantData_t<index> *data){
+		vkCmdPushConstants(commandBuffer,
+						   layout,
+						   pushConstantWithShaderStage_t<index>::stageFlagsValue,
+						   pushConstant_t<index>::offsetValue,
+						   sizeof(pushConstantData_t<index>),
+						   data);
+	}
+	
+	// Get the handle of a descriptor set
+	template <uint32_t index>
+	uniforms_t::template descriptorSet_t<index> &iDescriptorSet(){ return uniforms.template iDescriptorSet<index>(); }
+	
+	VkDescriptorPool GetVkDescriptorPool() const { return uniforms.GetVkDescriptorPool(); }
+	VkPipeline GetVkPipeline() const { return pipeline; }
+	
+protected:
+	std::shared_ptr<Devices> devices;
+	
+	uniforms_t uniforms;
+	
+	// from `Devices`' layout cache, which owns it
+	VkPipelineLayout layout;
+	
+	VkPipeline pipeline;
+	
+	static constexpr VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+};
+
+/*
+ A graphics pipeline whose geometry is generated by a mesh shader, optionally launched by a task shader, instead of read by a vertex shader. Requires VK_EXT_mesh_shader (see `Devices::SupportsMeshShaders`).
+ `RenderPipelineBlueprint::primitiveTopology` is not used; the mesh shader declares its output primitives.
+ */
+template <typename taskShader_t, typename meshShader_t, typename fragmentShader_t>
+requires (taskShader_c<taskShader_t> && meshShader_c<meshShader_t> && shader_c<fragmentShader_t>)
+class MeshPipeline {
+public:
+	using uniforms_t = Uniforms<withShaderStagesMerged_t<concatenatedPack_t<typename taskShader_t::uniformWithShaderStage_tp, typename meshShader_t::uniformWithShaderStage_tp, typename fragmentShader_t::uniformWithShaderStage_tp>>>;
+	
+	using pushConstantManager_t = PushConstantManager<withShaderStagesMerged_t<concatenatedPack_t<typename taskShader_t::pushConstantWithShaderStage_tp, typename meshShader_t::pushConstantWithShaderStage_tp, typename fragmentShader_t::pushConstantWithShaderStage_tp>>>;
+	
+	static constexpr uint32_t descriptorSetCount = uniforms_t::descriptorSetCount;
+	
+	static constexpr bool hasTaskShader = !std::same_as<taskShader_t, NoTaskShader>;
+	
+	MeshPipeline(std::shared_ptr<Devices> _devices, const RenderPipelineBlueprint *const pBlueprint)
+	: devices(_devices), uniforms(_devices) {
+		if(!devices->SupportsMeshShaders() || (hasTaskShader && !devices->SupportsTaskShaders())){
+			throw std::runtime_error("failed to create mesh pipeline; mesh or task shaders are not supported!");
 		}
+		
+		// pipeline layout
+		std::array<VkPushConstantRange, pushConstantManager_t::pushConstantCount> pcrs = pushConstantManager_t::PushConstantRanges();
+		const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.setLayoutCount = uniforms_t::descriptorSetCount, // Optional
+			.pSetLayouts = uniforms.DescriptorSetLayouts().data(), // Optional
+			.pushConstantRangeCount = pushConstantManager_t::pushConstantCount,
+			.pPushConstantRanges = pushConstantManager_t::pushConstantCount == 0 ? nullptr : pcrs.data()
+		};
+		layout = _devices->CachedPipelineLayout(pipelineLayoutInfo);
+		
+		// ----- Viewport state -----
+		const VkPipelineViewportStateCreateInfo viewportState {
+			 .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+			 .viewportCount = 1,
+			 .scissorCount = 1
+		};
+		// Shader stages
+		std::array<VkPipelineShaderStageCreateInfo, 3> stageCIs {};
+		uint32_t stageCount = 0;
+		if constexpr (hasTaskShader){
+			stageCIs[stageCount++] = {// task shader
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.stage = VK_SHADER_STAGE_TASK_BIT_EXT,
+				.pName = "main",
+				.module = devices->CreateShaderModule(taskShader_t::filenameValue.data()),
+				.pSpecializationInfo = nullptr
+			};
+		}
+		stageCIs[stageCount++] = {// mesh shader
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = VK_SHADER_STAGE_MESH_BIT_EXT,
+			.pName = "main",
+			.module = devices->CreateShaderModule(meshShader_t::filenameValue.data()),
+			.pSpecializationInfo = nullptr
+		};
+		stageCIs[stageCount++] = {// fragment shader
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+			.pName = "main",
+			.module = devices->CreateShaderModule(fragmentShader_t::filenameValue.data()),
+			.pSpecializationInfo = nullptr
+		};
+		
+		// Pipeline; mesh pipelines have no vertex input or input assembly state
+		const VkGraphicsPipelineCreateInfo pipelineInfo {
+			 .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+			 .flags = uniforms.PipelineCreateFlags(),
+			 .stageCount = stageCount,
+			 .pStages = stageCIs.data(),
+			 .pVertexInputState = nullptr,
+			 .pInputAssemblyState = nullptr,
+			 .pViewportState = &viewportState,
+			 .pRasterizationState = pBlueprint->pRasterisationStateCI,
+			 .pMultisampleState = pBlueprint->pMultisampleStateCI,
+			 .pDepthStencilState = pBlueprint->pDepthStencilStateCI, // Optional
+			 .pColorBlendState = pBlueprint->pColourBlendStateCI,
+			 .pDynamicState = pBlueprint->pDynamicStateCI,
+			 .layout = layout,
+			 .renderPass = pBlueprint->renderPassHandle,
+			 .subpass = 0,
+			 .basePipelineHandle = VK_NULL_HANDLE, // Optional
+			 .basePipelineIndex = -1 // Optional
+		};
+		if(vkCreateGraphicsPipelines(devices->GetLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS){
+			 throw std::runtime_error("failed to create mesh pipeline!");
+		}
+	}
+	~MeshPipeline(){
+		vkDestroyPipeline(devices->GetLogicalDevice(), pipeline, nullptr);
+	}
+	
+	// Bind the pipeline for subsequent render calls
+	void CmdBind(VkCommandBuffer commandBuffer) const {
+		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+	}
+	
+	// A typed list of the dynamic offset numbers for binding sets [`first`, `first + number`), one per dynamic UBO or SBO in binding order
+	template <uint32_t first=0, uint32_t number=0>
+	using dynamicOffsetNumbers_t = typename uniforms_t::template dynamicOffsetNumbers_t<first, (number < 1 ? descriptorSetCount - first : number)>;
+	
+	// Set which descriptor sets are bound for subsequent render calls. `dynamicOffsetNumbers` can be a `dynamicOffsetNumbers_t`, whose size is checked at compile time, or a `std::span` over the caller's storage, so binding needn't allocate; binding fails if a runtime-sized list has the wrong number of numbers.
+	template <uint32_t first=0, uint32_t number=0, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindDescriptorSets(const CommandEnvironment &commandEnvironment, const numbers_t &dynamicOffsetNumbers=numbers_t()) {
+		constexpr uint32_t numberUse = number < 1 ? descriptorSetCount - first : number;
+		
+		if(!DynamicOffsetNumbersMatch<uniforms_t::template dynamicOffsetNumberCount<first, numberUse>>(dynamicOffsetNumbers)){
+			return false;
+		}
+		
+		static_assert(uniforms_t::template SetsAllocated<first, numberUse>(), "Push descriptor sets are not bound; record them with `CmdPushDescriptors`.");
+		
+		// making sure all descriptor sets are valid
+		if(!uniforms.template UpdateDescriptorSets<first, numberUse>(commandEnvironment.flight)){
+			return false;
+		}
+		
+		if(uniforms.UsesDescriptorBuffers()){
+			uniforms.template CmdSetDescriptorBufferOffsets<first, numberUse>(commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout);
+			return true;
+		}
+		
+		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(commandEnvironment.flight) + first;
+		
+		// binding, with dynamic offsets for any dynamic or packed buffers
+		const auto dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(commandEnvironment.flight, dynamicOffsetNumbers);
+		vkCmdBindDescriptorSets(commandEnvironment.commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.empty() ? nullptr : dynamicOffsets.data());
 		return true;
 	}
 	
+	// Record the descriptors of push descriptor set `set` (see `PushedUniform`) for subsequent render calls; they can be changed and pushed again between draws
+	template <uint32_t set>
+	[[nodiscard]]
+	bool CmdPushDescriptors(const CommandEnvironment &commandEnvironment) const {
+		return uniforms.template CmdPushDescriptorSet<set>(commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout);
+	}
+	
+	// Bind a `SharedDescriptorSet` at its set index, in place of this pipeline's own set there. It stays bound for subsequent pipelines whose layouts are compatible for it, so needn't be bound again after switching between them.
+	template <typename sharedDescriptorSet_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindSharedDescriptorSet(const CommandEnvironment &commandEnvironment, sharedDescriptorSet_t &sharedDescriptorSet, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template SharedSetCompatible<sharedDescriptorSet_t>(), "The shared descriptor set's layout should be identically defined to the pipeline's at its set index.");
+		return sharedDescriptorSet.CmdBind(commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Bind instance `id` of a `DescriptorSetAllocator` at set `set`, in place of this pipeline's own set there, e.g. to switch materials between draws
+	template <uint32_t set, typename descriptorSetAllocator_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindDescriptorSetInstance(const CommandEnvironment &commandEnvironment, descriptorSetAllocator_t &allocator, typename descriptorSetAllocator_t::InstanceID id, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template DescriptorSetCompatible<set, typename descriptorSetAllocator_t::descriptorSet_t>(), "The allocator's descriptor set layout should be identically defined to the pipeline's at the set index.");
+		return allocator.CmdBind(id, commandEnvironment.commandBuffer, commandEnvironment.flight, bindPoint, layout, set, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Launch `groupCountX * groupCountY * groupCountZ` task shader work groups, or mesh shader work groups if there is no task shader
+	void CmdDrawMeshTasks(const CommandEnvironment &commandEnvironment, uint32_t groupCountX, uint32_t groupCountY=1, uint32_t groupCountZ=1) const {
+		devices->CmdDrawMeshTasks(commandEnvironment.commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+	
+	// Draw with `drawCount` `VkDrawMeshTasksIndirectCommandEXT`s read from `drawCommands`, starting at `offset` into the flight's copy
+	void CmdDrawMeshTasksIndirect(const CommandEnvironment &commandEnvironment, const StorageBufferObject &drawCommands, uint32_t drawCount, VkDeviceSize offset=0) const {
+		devices->CmdDrawMeshTasksIndirect(commandEnvironment.commandBuffer, drawCommands.BufferFlying(commandEnvironment.flight), offset + commandEnvironment.flight * drawCommands.FlightStride(), drawCount);
+	}
+	
 	template <uint32_t index>
 	using pushConstantWithShaderStage_t = typename pushConstantManager_t::template pushConstantWithShaderStage_t<index>;
 	
@@ -984,6 +2054,7 @@ protected:
 	
 	uniforms_t uniforms;
 	
+	// from `Devices`' layout cache, which owns it
 	VkPipelineLayout layout;
 	
 	VkPipeline pipeline;
@@ -1014,9 +2085,7 @@ public:
 			.pushConstantRangeCount = pushConstantManager_t::pushConstantCount,
 			.pPushConstantRanges = pushConstantManager_t::pushConstantCount == 0 ? nullptr : pcrs.data()
 		};
-		if(vkCreatePipelineLayout(_devices->GetLogicalDevice(), &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS){
-			throw std::runtime_error("Failed to create pipeline layout!");
-		}
+		layout = _devices->CachedPipelineLayout(pipelineLayoutInfo);
 		
 		// Shader stage
 		const VkPipelineShaderStageCreateInfo stageCI = {
@@ -1031,6 +2100,7 @@ public:
 		// Pipeline
 		VkComputePipelineCreateInfo pipelineInfo{
 			.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			.flags = uniforms.PipelineCreateFlags(),
 			.stage = stageCI,
 			.layout = layout
 		};
@@ -1040,7 +2110,6 @@ public:
 	}
 	~ComputePipeline(){
 		vkDestroyPipeline(devices->GetLogicalDevice(), pipeline, nullptr);
-		vkDestroyPipelineLayout(devices->GetLogicalDevice(), layout, nullptr);
 //		vkDestroyShaderModule(devices->GetLogicalDevice(), fragShaderModule, nullptr);
 //		vkDestroyShaderModule(devices->GetLogicalDevice(), vertShaderModule, nullptr);
 	}
@@ -1050,29 +2119,63 @@ public:
 		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
 	}
 	
-	// Set which descriptor sets are bound for subsequent render calls
+	// A typed list of the dynamic offset numbers for binding sets [`first`, `first + number`), one per dynamic UBO or SBO in binding order
 	template <uint32_t first=0, uint32_t number=0>
+	using dynamicOffsetNumbers_t = typename uniforms_t::template dynamicOffsetNumbers_t<first, (number < 1 ? descriptorSetCount - first : number)>;
+	
+	// Set which descriptor sets are bound for subsequent render calls. `dynamicOffsetNumbers` can be a `dynamicOffsetNumbers_t`, whose size is checked at compile time, or a `std::span` over the caller's storage, so binding needn't allocate; binding fails if a runtime-sized list has the wrong number of numbers.
+	template <uint32_t first=0, uint32_t number=0, typename numbers_t=std::vector<int>>
 	[[nodiscard]]
-	bool CmdBindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t flight, const std::vector<int> &dynamicOffsetNumbers=std::vector<int>()) {
+	bool CmdBindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t flight, const numbers_t &dynamicOffsetNumbers=numbers_t()) {
 		constexpr uint32_t numberUse = number < 1 ? descriptorSetCount - first : number;
 		
-		// making sure all descriptor sets are valid
-		if(!uniforms.template UpdateDescriptorSets<first, numberUse>()){
+		if(!DynamicOffsetNumbersMatch<uniforms_t::template dynamicOffsetNumberCount<first, numberUse>>(dynamicOffsetNumbers)){
 			return false;
 		}
 		
-		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(flight);
+		static_assert(uniforms_t::template SetsAllocated<first, numberUse>(), "Push descriptor sets are not bound; record them with `CmdPushDescriptors`.");
 		
-		// binding, optionally using dynamic offsets
-		if(dynamicOffsetNumbers.empty()){
-			vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, 0, nullptr);
-		} else {
-			const std::vector<uint32_t> dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(dynamicOffsetNumbers);
-			vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+		// making sure all descriptor sets are valid
+		if(!uniforms.template UpdateDescriptorSets<first, numberUse>(flight)){
+			return false;
 		}
+		
+		if(uniforms.UsesDescriptorBuffers()){
+			uniforms.template CmdSetDescriptorBufferOffsets<first, numberUse>(commandBuffer, flight, bindPoint, layout);
+			return true;
+		}
+		
+		const VkDescriptorSet *const firstDescriptorSet = uniforms.DescriptorSetsStart(flight) + first;
+		
+		// binding, with dynamic offsets for any dynamic or packed buffers
+		const auto dynamicOffsets = uniforms.template GetDynamicOffsets<first, numberUse>(flight, dynamicOffsetNumbers);
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, first, numberUse, firstDescriptorSet, uint32_t(dynamicOffsets.size()), dynamicOffsets.empty() ? nullptr : dynamicOffsets.data());
 		return true;
 	}
 	
+	// Record the descriptors of push descriptor set `set` (see `PushedUniform`) for subsequent render calls; they can be changed and pushed again between draws
+	template <uint32_t set>
+	[[nodiscard]]
+	bool CmdPushDescriptors(VkCommandBuffer commandBuffer, uint32_t flight) const {
+		return uniforms.template CmdPushDescriptorSet<set>(commandBuffer, flight, bindPoint, layout);
+	}
+	
+	// Bind a `SharedDescriptorSet` at its set index, in place of this pipeline's own set there. It stays bound for subsequent pipelines whose layouts are compatible for it, so needn't be bound again after switching between them.
+	template <typename sharedDescriptorSet_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindSharedDescriptorSet(VkCommandBuffer commandBuffer, uint32_t flight, sharedDescriptorSet_t &sharedDescriptorSet, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template SharedSetCompatible<sharedDescriptorSet_t>(), "The shared descriptor set's layout should be identically defined to the pipeline's at its set index.");
+		return sharedDescriptorSet.CmdBind(commandBuffer, flight, bindPoint, layout, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
+	// Bind instance `id` of a `DescriptorSetAllocator` at set `set`, in place of this pipeline's own set there
+	template <uint32_t set, typename descriptorSetAllocator_t, typename numbers_t=std::vector<int>>
+	[[nodiscard]]
+	bool CmdBindDescriptorSetInstance(VkCommandBuffer commandBuffer, uint32_t flight, descriptorSetAllocator_t &allocator, typename descriptorSetAllocator_t::InstanceID id, const numbers_t &dynamicOffsetNumbers=numbers_t()) const {
+		static_assert(uniforms_t::template DescriptorSetCompatible<set, typename descriptorSetAllocator_t::descriptorSet_t>(), "The allocator's descriptor set layout should be identically defined to the pipeline's at the set index.");
+		return allocator.CmdBind(id, commandBuffer, flight, bindPoint, layout, set, uniforms.UsesDescriptorBuffers(), dynamicOffsetNumbers);
+	}
+	
 	template <uint32_t index>
 	using pushConstantWithShaderStage_t = typename pushConstantManager_t::template pushConstantWithShaderStage_t<index>;
 	
@@ -1105,6 +2208,7 @@ protected:
 	
 	uniforms_t uniforms;
 	
+	// from `Devices`' layout cache, which owns it
 	VkPipelineLayout layout;
 	
 	VkPipeline pipeline;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "DescriptorBase.hpp"
+
+namespace EVK {
+
+// Binds the first `mipCount` mip levels of one image as an array of storage images, e.g. for building a mip chain in a compute shader. Levels beyond the image's own are bound to its last level.
+template <uint32_t binding, VkShaderStageFlags stageFlags, uint32_t mipCount>
+class StorageImageMipsDescriptor : public DescriptorBase<binding, stageFlags> {
+public:
+	using DescriptorBase = typename StorageImageMipsDescriptor::DescriptorBase;
+	static constexpr uint32_t bindingValue = binding;
+	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
+	
+	StorageImageMipsDescriptor() = default;
+	
+	// `value` must have been created with `ManualImageBlueprint::mipViews`
+	void Set(const std::shared_ptr<TextureImage> &value){
+		if(value && !value->HasMipViews()){
+			std::cout << "Cannot bind image mips; the image has no mip views.\n";
+			return;
+		}
+		image = value;
+		DescriptorBase::valid = false;
+	}
+	
+	static constexpr VkDescriptorSetLayoutBinding layoutBinding = {
+		.binding = binding,
+		.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		.descriptorCount = mipCount,
+		.stageFlags = stageFlags,
+		.pImmutableSamplers = nullptr
+	};
+	
+	std::optional<VkWriteDescriptorSet> DescriptorWrite(const VkDescriptorSet &dstSet, VkDescriptorImageInfo *imageInfoBuffer, int &imageInfoBufferIndex, VkDescriptorBufferInfo *bufferInfoBuffer, int &bufferInfoBufferIndex, int flight) const override {
+		if(!image){
+			return {};
+		}
+		const int startIndex = imageInfoBufferIndex;
+		for(uint32_t mip=0; mip<mipCount; ++mip){
+			imageInfoBuffer[imageInfoBufferIndex].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			imageInfoBuffer[imageInfoBufferIndex].imageView = image->MipView(std::min(mip, image->MipLevels() - 1));
+			imageInfoBuffer[imageInfoBufferIndex].sampler = nullptr;
+			imageInfoBufferIndex++;
+		}
+		
+		return (VkWriteDescriptorSet){
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = dstSet,
+			.dstBinding = binding,
+			.dstArrayElement = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			.descriptorCount = mipCount,
+			.pImageInfo = &imageInfoBuffer[startIndex]
+		};
+	}
+	
+	uint64_t HandleVersion() const override {
+		return image ? image->HandleVersion() : 0;
+	}
+	
+	static constexpr VkDescriptorPoolSize poolSize = {
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		.descriptorCount = mipCount * MAX_FRAMES_IN_FLIGHT
+	};
+	
+private:
+	std::shared_ptr<TextureImage> image {};
+};
+
+} // namespace EVK
@@ -10,6 +10,7 @@ public:
 	using DescriptorBase = typename TextureImagesDescriptor::DescriptorBase;
 	static constexpr uint32_t bindingValue = binding;
 	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
 	
 	TextureImagesDescriptor() = default;
 	
@@ -51,6 +52,16 @@ public:
 		};
 	}
 	
+	uint64_t HandleVersion() const override {
+		uint64_t ret = 0;
+		for(const std::shared_ptr<TextureImage> &image : images){
+			if(image){
+				ret += image->HandleVersion();
+			}
+		}
+		return ret;
+	}
+	
 	static constexpr VkDescriptorPoolSize poolSize = {
 		.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
 		.descriptorCount = imageCount * MAX_FRAMES_IN_FLIGHT
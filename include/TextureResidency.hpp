@@ -0,0 +1,53 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "Resources.hpp"
+
+namespace EVK {
+
+/*
+ Keeps the device memory used by streamed textures (see `DataImageBlueprint::streamed`) under a fraction of the VMA heap budget.
+ Every frame, mark the textures that are drawn with `MarkUsed`, and call `Update` with the next frame's command buffer straight after `EVK::Interface::BeginFrame`, before any render pass is begun or descriptor set bound; the uploads are recorded into it rather than waited on.
+ When over budget, the top mips of the least recently used textures are dropped; when there is room, used textures are refined one mip level at a time.
+ Textures that have their mips changed get new handles, so descriptors referencing them are re-written automatically on the next bind.
+ */
+class TextureResidencyManager {
+public:
+	struct Settings {
+		float budgetFraction; // of the budget of the device local heaps reported by VMA
+		uint32_t residentTailLevels; // this many of the smallest mip levels are never evicted
+		uint32_t maxUploadsPerUpdate;
+	};
+	
+	TextureResidencyManager(std::shared_ptr<Devices> _devices, const Settings &_settings);
+	
+	[[nodiscard]] bool Add(const std::shared_ptr<TextureImage> &texture);
+	void Remove(const std::shared_ptr<TextureImage> &texture);
+	
+	void MarkUsed(const std::shared_ptr<TextureImage> &texture);
+	
+	void Update(VkCommandBuffer commandBuffer);
+	
+	[[nodiscard]] VkDeviceSize Budget() const;
+	[[nodiscard]] VkDeviceSize ResidentSize() const;
+	
+private:
+	std::shared_ptr<Devices> devices;
+	
+	Settings settings;
+	
+	struct Entry {
+		std::shared_ptr<TextureImage> texture;
+		uint64_t lastUsedFrame;
+	};
+	std::unordered_map<const TextureImage *, Entry> entries {};
+	
+	uint64_t frame = 0;
+	
+	[[nodiscard]] uint32_t MaxBaseMip(const TextureImage &texture) const {
+		return texture.MipLevels() > settings.residentTailLevels ? texture.MipLevels() - settings.residentTailLevels : 0;
+	}
+};
+
+} // namespace EVK
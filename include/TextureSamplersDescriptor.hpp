@@ -10,6 +10,7 @@ public:
 	using DescriptorBase = typename TextureSamplersDescriptor::DescriptorBase;
 	static constexpr uint32_t bindingValue = binding;
 	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = true;
 	
 	TextureSamplersDescriptor() = default;
 	
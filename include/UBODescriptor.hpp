@@ -10,6 +10,8 @@ public:
 	using DescriptorBase = typename UBODescriptor::DescriptorBase;
 	static constexpr uint32_t bindingValue = binding;
 	static constexpr VkShaderStageFlags stageFlagsValue = stageFlags;
+	static constexpr bool flightInvariant = false;
+	static constexpr bool consumesDynamicOffsetNumber = dynamic;
 	
 	UBODescriptor() = default;
 	
@@ -0,0 +1,78 @@
+#include <vma/vk_mem_alloc.h>
+
+#include <Defragmenter.hpp>
+
+namespace EVK {
+
+Defragmenter::Defragmenter(std::shared_ptr<Devices> _devices, const Budget &_budget)
+: devices(std::move(_devices)), budget(_budget) {}
+
+Defragmenter::~Defragmenter(){
+	Finish();
+}
+
+bool Defragmenter::Step(){
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	
+	// the context is not kept between steps, as the application may free allocations in between
+	const VmaDefragmentationInfo info{
+		.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+		.pool = nullptr,
+		.maxBytesPerPass = budget.maxBytesPerPass,
+		.maxAllocationsPerPass = budget.maxAllocationsPerPass
+	};
+	if(vmaBeginDefragmentation(devices->GetAllocator(), &info, &context) != VK_SUCCESS){
+		throw std::runtime_error("failed to begin defragmentation!");
+	}
+	
+	bool moved = false;
+	std::vector<std::pair<Relocatable *, VmaAllocation>> relocations {};
+	do {
+		VmaDefragmentationPassMoveInfo pass;
+		if(vmaBeginDefragmentationPass(devices->GetAllocator(), context, &pass) == VK_SUCCESS){
+			// nothing left to move
+			break;
+		}
+		
+		VkCommandBuffer commandBuffer = devices->BeginSingleTimeCommands();
+		relocations.clear();
+		for(uint32_t i=0; i<pass.moveCount; ++i){
+			VmaDefragmentationMove &move = pass.pMoves[i];
+			VmaAllocationInfo allocationInfo;
+			vmaGetAllocationInfo(devices->GetAllocator(), move.srcAllocation, &allocationInfo);
+			Relocatable *const owner = static_cast<Relocatable *>(allocationInfo.pUserData);
+			if(owner && owner->CmdRelocate(commandBuffer, move.srcAllocation, move.dstTmpAllocation)){
+				relocations.push_back({owner, move.srcAllocation});
+			} else {
+				move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+			}
+		}
+		// this waits for the graphics queue to go idle, so the copies are complete and no submitted frame is still using the old memory
+		devices->EndSingleTimeCommands(commandBuffer);
+		
+		// after this the source allocations refer to the new memory
+		const VkResult result = vmaEndDefragmentationPass(devices->GetAllocator(), context, &pass);
+		
+		for(const auto &[owner, allocation] : relocations){
+			owner->FinishRelocation(allocation);
+		}
+		moved |= !relocations.empty();
+		
+		if(result == VK_SUCCESS){
+			break;
+		}
+	} while(std::chrono::steady_clock::now() - start < budget.maxTimePerStep);
+	
+	Finish();
+	return moved;
+}
+
+void Defragmenter::Finish(){
+	if(!context){
+		return;
+	}
+	vmaEndDefragmentation(devices->GetAllocator(), context, nullptr);
+	context = nullptr;
+}
+
+} // namespace EVK
@@ -1,4 +1,5 @@
 #include <set>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <format>
@@ -37,6 +38,22 @@ const std::vector<const char *> deviceExtensions = {
 };
 const std::vector<const char *> instanceExtensions = {};
 
+// enumerated once per physical device, then queried for both the required and the optional extensions
+static std::set<std::string> AvailableDeviceExtensions(const VkPhysicalDevice &device){
+	uint32_t deviceExtensionCount;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &deviceExtensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(deviceExtensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &deviceExtensionCount, availableExtensions.data());
+	std::set<std::string> ret {};
+	for(const VkExtensionProperties &extension : availableExtensions){
+		ret.insert(extension.extensionName);
+	}
+	return ret;
+}
+static bool DeviceExtensionAvailable(const std::set<std::string> &availableExtensions, const char *extensionName){
+	return availableExtensions.contains(extensionName);
+}
+
 #define QUEUE_FAMILIES_N 2
 static QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice &device, const VkSurfaceKHR &surface){
 	QueueFamilyIndices ret;
@@ -56,7 +73,7 @@ static QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice &device, cons
 	return ret;
 }
 
-static bool CheckDeviceExtensionSupport(const VkPhysicalDevice &device){
+static bool CheckDeviceExtensionSupport(const std::set<std::string> &availableDeviceExtensions){
 	{
 		uint32_t instancedExtensionCount;
 		vkEnumerateInstanceExtensionProperties(nullptr, &instancedExtensionCount, nullptr);
@@ -70,17 +87,8 @@ static bool CheckDeviceExtensionSupport(const VkPhysicalDevice &device){
 		if(!requiredExtensions.empty()) return false;
 	}
 	
-	{
-		uint32_t deviceExtensionCount;
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &deviceExtensionCount, nullptr);
-		std::vector<VkExtensionProperties> availableExtensions(deviceExtensionCount);
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &deviceExtensionCount, availableExtensions.data());
-		
-		std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
-		for(VkExtensionProperties extension : availableExtensions)
-			requiredExtensions.erase(extension.extensionName);
-		
-		if(!requiredExtensions.empty()) return false;
+	for(const char *extension : deviceExtensions){
+		if(!DeviceExtensionAvailable(availableDeviceExtensions, extension)) return false;
 	}
 	
 	return true;
@@ -108,10 +116,10 @@ static SwapChainSupportDetails QueryDevicesSwapChainSupport(const VkPhysicalDevi
 }
 SwapChainSupportDetails Devices::QuerySwapChainSupport() const { return QueryDevicesSwapChainSupport(physicalDevice, surface); }
 
-static bool IsDeviceSuitable(const VkPhysicalDevice &device, const VkSurfaceKHR &surface){
+static bool IsDeviceSuitable(const VkPhysicalDevice &device, const VkSurfaceKHR &surface, const std::set<std::string> &availableExtensions){
 	QueueFamilyIndices indices = FindQueueFamilies(device, surface);
 	
-	const bool extensionsSupported = CheckDeviceExtensionSupport(device);
+	const bool extensionsSupported = CheckDeviceExtensionSupport(availableExtensions);
 	
 	bool swapChainAdequate = false;
 	if(extensionsSupported){
@@ -157,7 +165,8 @@ Devices::Devices(const char *applicationName,
 				 std::vector<const char *> requiredExtensions,
 				 std::function<VkSurfaceKHR (VkInstance)> surfaceCreationFunction,
 				 const std::function<VkExtent2D ()> &_getExtentFunction,
-				 VkPhysicalDeviceFeatures gpuFeatures)
+				 VkPhysicalDeviceFeatures gpuFeatures,
+				 bool useDescriptorBuffers)
 : getExtentFunction(_getExtentFunction) {
 	
 	// -----
@@ -213,8 +222,10 @@ Devices::Devices(const char *applicationName,
 		VkPhysicalDevice physicalDevices[deviceCount];
 		vkEnumeratePhysicalDevices(instance, &deviceCount, physicalDevices);
 		// this finds all GPUs with Vulkan support. If we are picky, we can look at the other supported features in each one and choose, but this is only needed for use of geometry shaders and things like that
+		std::set<std::string> availableExtensions {};
 		for(int i=0; i<deviceCount; i++){
-			if(IsDeviceSuitable(physicalDevices[i], surface)){
+			availableExtensions = AvailableDeviceExtensions(physicalDevices[i]);
+			if(IsDeviceSuitable(physicalDevices[i], surface, availableExtensions)){
 				physicalDevice = physicalDevices[i];
 #ifdef MSAA
 				msaaSamples = GetMaxUsableSampleCount();
@@ -226,6 +237,105 @@ Devices::Devices(const char *applicationName,
 		
 		// ----- Getting properties -----
 		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+		
+		// ----- Optional extensions -----
+		if(DeviceExtensionAvailable(availableExtensions, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)){
+			VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProperties{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT
+			};
+			VkPhysicalDeviceProperties2 properties2{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+				.pNext = &hostProperties
+			};
+			vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+			hostImportAlignment = hostProperties.minImportedHostPointerAlignment;
+		}
+		if(DeviceExtensionAvailable(availableExtensions, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)){
+			VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR
+			};
+			VkPhysicalDeviceProperties2 properties2{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+				.pNext = &pushDescriptorProperties
+			};
+			vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+			maxPushDescriptors = pushDescriptorProperties.maxPushDescriptors;
+		}
+		
+		// ----- Optional features -----
+		// extension feature structures are only chained if the extension is available
+		VkPhysicalDeviceConditionalRenderingFeaturesEXT supportedConditionalRendering{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT
+		};
+		VkPhysicalDeviceMeshShaderFeaturesEXT supportedMeshShader{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT
+		};
+		VkPhysicalDeviceDescriptorBufferFeaturesEXT supportedDescriptorBuffer{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT
+		};
+		VkPhysicalDeviceSynchronization2FeaturesKHR supportedSynchronization2{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR
+		};
+		VkPhysicalDeviceVulkan12Features supportedFeatures12{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+		};
+		void **chainEnd = &supportedFeatures12.pNext;
+		if(DeviceExtensionAvailable(availableExtensions, VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME)){
+			*chainEnd = &supportedConditionalRendering;
+			chainEnd = &supportedConditionalRendering.pNext;
+		}
+		if(DeviceExtensionAvailable(availableExtensions, VK_EXT_MESH_SHADER_EXTENSION_NAME)){
+			*chainEnd = &supportedMeshShader;
+			chainEnd = &supportedMeshShader.pNext;
+		}
+		// below Vulkan 1.3, VK_EXT_descriptor_buffer depends on VK_KHR_synchronization2
+		if(useDescriptorBuffers && DeviceExtensionAvailable(availableExtensions, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) && DeviceExtensionAvailable(availableExtensions, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)){
+			*chainEnd = &supportedDescriptorBuffer;
+			chainEnd = &supportedDescriptorBuffer.pNext;
+			*chainEnd = &supportedSynchronization2;
+			chainEnd = &supportedSynchronization2.pNext;
+		}
+		VkPhysicalDeviceFeatures2 supportedFeatures{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+			.pNext = &supportedFeatures12
+		};
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+		gpuFeatures.multiDrawIndirect = supportedFeatures.features.multiDrawIndirect;
+		// culled indirect draws carry their instance's index in `firstInstance`
+		gpuFeatures.drawIndirectFirstInstance = supportedFeatures.features.drawIndirectFirstInstance;
+		gpuFeatures.shaderStorageImageArrayDynamicIndexing = supportedFeatures.features.shaderStorageImageArrayDynamicIndexing;
+		features12.drawIndirectCount = supportedFeatures12.drawIndirectCount;
+		// buffer device addresses, for shaders to reach buffers through pointers (see `StorageBufferObject::DeviceAddress`)
+		features12.bufferDeviceAddress = supportedFeatures12.bufferDeviceAddress;
+		gpuFeatures.shaderInt64 = supportedFeatures.features.shaderInt64;
+		// descriptor indexing, for bindless textures
+		if(supportedFeatures12.descriptorBindingPartiallyBound &&
+		   supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind &&
+		   supportedFeatures12.descriptorBindingUpdateUnusedWhilePending &&
+		   supportedFeatures12.descriptorBindingVariableDescriptorCount &&
+		   supportedFeatures12.runtimeDescriptorArray &&
+		   supportedFeatures12.shaderSampledImageArrayNonUniformIndexing){
+			features12.descriptorIndexing = supportedFeatures12.descriptorIndexing;
+			features12.descriptorBindingPartiallyBound = VK_TRUE;
+			features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			features12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+			features12.runtimeDescriptorArray = VK_TRUE;
+			features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		}
+		conditionalRenderingFeatures.conditionalRendering = supportedConditionalRendering.conditionalRendering;
+		meshShaderFeatures.meshShader = supportedMeshShader.meshShader;
+		meshShaderFeatures.taskShader = supportedMeshShader.meshShader && supportedMeshShader.taskShader;
+		// descriptor buffers refer to buffers by device address
+		if(supportedDescriptorBuffer.descriptorBuffer && supportedSynchronization2.synchronization2 && supportedFeatures12.bufferDeviceAddress){
+			descriptorBufferFeatures.descriptorBuffer = VK_TRUE;
+			synchronization2Features.synchronization2 = VK_TRUE;
+			VkPhysicalDeviceProperties2 properties2{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+				.pNext = &descriptorBufferProperties
+			};
+			vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+		}
 	}
 	
 	
@@ -257,17 +367,84 @@ Devices::Devices(const char *applicationName,
 		//gpuFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE; // ? added to this to try fix textures, didn't help
 		//gpuFeatures.shaderUniformBufferArrayDynamicIndexing = VK_TRUE; // ? added this because it looks like I should (dynamic ubos worked without it)
 		
+		std::vector<const char *> enabledExtensions = deviceExtensions;
+		if(hostImportAlignment){
+			enabledExtensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+		}
+		if(maxPushDescriptors){
+			enabledExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		}
+		void **chainEnd = &features12.pNext;
+		if(conditionalRenderingFeatures.conditionalRendering){
+			enabledExtensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+			*chainEnd = &conditionalRenderingFeatures;
+			chainEnd = &conditionalRenderingFeatures.pNext;
+		}
+		if(meshShaderFeatures.meshShader){
+			enabledExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+			*chainEnd = &meshShaderFeatures;
+			chainEnd = &meshShaderFeatures.pNext;
+		}
+		if(descriptorBufferFeatures.descriptorBuffer){
+			enabledExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+			enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+			*chainEnd = &descriptorBufferFeatures;
+			chainEnd = &descriptorBufferFeatures.pNext;
+			*chainEnd = &synchronization2Features;
+			chainEnd = &synchronization2Features.pNext;
+		}
+		
 		VkDeviceCreateInfo createInfo {
 			.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+			.pNext = &features12,
 			.queueCreateInfoCount = QUEUE_FAMILIES_N,
 			.pQueueCreateInfos = queueCreateInfos,
 			.enabledLayerCount = 0,
 			.pEnabledFeatures = &gpuFeatures,
-			.enabledExtensionCount = uint32_t(deviceExtensions.size()),
-			.ppEnabledExtensionNames = deviceExtensions.data()
+			.enabledExtensionCount = uint32_t(enabledExtensions.size()),
+			.ppEnabledExtensionNames = enabledExtensions.data()
 		};
 		if(vkCreateDevice(physicalDevice, &createInfo, nullptr, &logicalDevice) != VK_SUCCESS)
 			throw std::runtime_error("failed to create logical device!");
+		features = gpuFeatures;
+		
+		if(hostImportAlignment){
+			getMemoryHostPointerProperties = reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(vkGetDeviceProcAddr(logicalDevice, "vkGetMemoryHostPointerPropertiesEXT"));
+			if(!getMemoryHostPointerProperties){
+				hostImportAlignment = 0;
+			}
+		}
+		if(maxPushDescriptors){
+			cmdPushDescriptorSet = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(vkGetDeviceProcAddr(logicalDevice, "vkCmdPushDescriptorSetKHR"));
+			if(!cmdPushDescriptorSet){
+				maxPushDescriptors = 0;
+			}
+		}
+		if(conditionalRenderingFeatures.conditionalRendering){
+			cmdBeginConditionalRendering = reinterpret_cast<PFN_vkCmdBeginConditionalRenderingEXT>(vkGetDeviceProcAddr(logicalDevice, "vkCmdBeginConditionalRenderingEXT"));
+			cmdEndConditionalRendering = reinterpret_cast<PFN_vkCmdEndConditionalRenderingEXT>(vkGetDeviceProcAddr(logicalDevice, "vkCmdEndConditionalRenderingEXT"));
+			if(!cmdBeginConditionalRendering || !cmdEndConditionalRendering){
+				conditionalRenderingFeatures.conditionalRendering = VK_FALSE;
+			}
+		}
+		if(meshShaderFeatures.meshShader){
+			cmdDrawMeshTasks = reinterpret_cast<PFN_vkCmdDrawMeshTasksEXT>(vkGetDeviceProcAddr(logicalDevice, "vkCmdDrawMeshTasksEXT"));
+			cmdDrawMeshTasksIndirect = reinterpret_cast<PFN_vkCmdDrawMeshTasksIndirectEXT>(vkGetDeviceProcAddr(logicalDevice, "vkCmdDrawMeshTasksIndirectEXT"));
+			if(!cmdDrawMeshTasks || !cmdDrawMeshTasksIndirect){
+				meshShaderFeatures.meshShader = VK_FALSE;
+				meshShaderFeatures.taskShader = VK_FALSE;
+			}
+		}
+		if(descriptorBufferFeatures.descriptorBuffer){
+			getDescriptorSetLayoutSize = reinterpret_cast<PFN_vkGetDescriptorSetLayoutSizeEXT>(vkGetDeviceProcAddr(logicalDevice, "vkGetDescriptorSetLayoutSizeEXT"));
+			getDescriptorSetLayoutBindingOffset = reinterpret_cast<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(vkGetDeviceProcAddr(logicalDevice, "vkGetDescriptorSetLayoutBindingOffsetEXT"));
+			getDescriptor = reinterpret_cast<PFN_vkGetDescriptorEXT>(vkGetDeviceProcAddr(logicalDevice, "vkGetDescriptorEXT"));
+			cmdBindDescriptorBuffers = reinterpret_cast<PFN_vkCmdBindDescriptorBuffersEXT>(vkGetDeviceProcAddr(logicalDevice, "vkCmdBindDescriptorBuffersEXT"));
+			cmdSetDescriptorBufferOffsets = reinterpret_cast<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(vkGetDeviceProcAddr(logicalDevice, "vkCmdSetDescriptorBufferOffsetsEXT"));
+			if(!getDescriptorSetLayoutSize || !getDescriptorSetLayoutBindingOffset || !getDescriptor || !cmdBindDescriptorBuffers || !cmdSetDescriptorBufferOffsets){
+				descriptorBufferFeatures.descriptorBuffer = VK_FALSE;
+			}
+		}
 	}
 	
 	
@@ -288,6 +465,7 @@ Devices::Devices(const char *applicationName,
 			.vkGetDeviceProcAddr = &vkGetDeviceProcAddr
 		};
 		VmaAllocatorCreateInfo createInfo{
+			.flags = features12.bufferDeviceAddress ? VmaAllocatorCreateFlags(VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT) : VmaAllocatorCreateFlags(0),
 			.physicalDevice = physicalDevice,
 			.device = logicalDevice,
 			.pHeapSizeLimit = nullptr,
@@ -298,6 +476,39 @@ Devices::Devices(const char *applicationName,
 		};
 		if(vmaCreateAllocator(&createInfo, &allocator) != VK_SUCCESS)
 			throw std::runtime_error("failed to create memory allocator!");
+		
+		// checking for memory that is both fast for the device and mappable by the host, which lets uploads skip staging
+		const VkPhysicalDeviceMemoryProperties *memoryProperties;
+		vmaGetMemoryProperties(allocator, &memoryProperties);
+		for(uint32_t i=0; i<memoryProperties->memoryTypeCount; ++i){
+			const VkMemoryPropertyFlags unified = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			if((memoryProperties->memoryTypes[i].propertyFlags & unified) == unified){
+				hostVisibleDeviceLocalMemory = true;
+				break;
+			}
+		}
+	}
+	
+	// -----
+	// Creating the descriptor buffer
+	// -----
+	if(descriptorBufferFeatures.descriptorBuffer){
+		const VkDeviceSize capacity = std::min({descriptorBufferCapacity, descriptorBufferProperties.maxResourceDescriptorBufferRange, descriptorBufferProperties.maxSamplerDescriptorBufferRange});
+		VmaAllocationInfo allocationInfo;
+		CreateBuffer(capacity,
+					 VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					 descriptorBuffer,
+					 descriptorBufferAllocation,
+					 &allocationInfo);
+		descriptorBufferData = static_cast<std::byte *>(allocationInfo.pMappedData);
+		descriptorBufferAddress = BufferDeviceAddress(descriptorBuffer);
+		const VmaVirtualBlockCreateInfo blockCI{
+			.size = capacity
+		};
+		if(vmaCreateVirtualBlock(&blockCI, &descriptorBufferBlock) != VK_SUCCESS){
+			throw std::runtime_error("failed to create descriptor buffer block!");
+		}
 	}
 	
 	// -----
@@ -315,6 +526,26 @@ Devices::Devices(const char *applicationName,
 	}
 }
 Devices::~Devices(){
+	vkDeviceWaitIdle(logicalDevice);
+	ExecuteDestructions(UINT64_MAX);
+	
+	if(descriptorBufferBlock != VK_NULL_HANDLE){
+		vmaClearVirtualBlock(descriptorBufferBlock);
+		vmaDestroyVirtualBlock(descriptorBufferBlock);
+		vmaDestroyBuffer(allocator, descriptorBuffer, descriptorBufferAllocation);
+	}
+	
+	for(const auto &[hash, bucket] : pipelineLayoutCache){
+		for(const CachedPipelineLayoutEntry &entry : bucket){
+			vkDestroyPipelineLayout(logicalDevice, entry.handle, nullptr);
+		}
+	}
+	for(const auto &[hash, bucket] : descriptorSetLayoutCache){
+		for(const CachedDescriptorSetLayoutEntry &entry : bucket){
+			vkDestroyDescriptorSetLayout(logicalDevice, entry.handle, nullptr);
+		}
+	}
+	
 	vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
 	vmaDestroyAllocator(allocator);
 	vkDestroyDevice(logicalDevice, nullptr);
@@ -325,6 +556,67 @@ Devices::~Devices(){
 	vkDestroyInstance(instance, nullptr);
 }
 
+VkDescriptorSetLayout Devices::CachedDescriptorSetLayout(uint64_t hash, const VkDescriptorSetLayoutCreateInfo &createInfo){
+	CachedDescriptorSetLayoutEntry entry{
+		.flags = createInfo.flags,
+		.bindings = std::vector<VkDescriptorSetLayoutBinding>(createInfo.pBindings, createInfo.pBindings + createInfo.bindingCount)
+	};
+	// binding flags are the only structure chained onto descriptor set layout create infos here
+	if(const VkBaseInStructure *next = static_cast<const VkBaseInStructure *>(createInfo.pNext); next && next->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO){
+		const VkDescriptorSetLayoutBindingFlagsCreateInfo *bindingFlags = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo *>(next);
+		entry.bindingFlags.assign(bindingFlags->pBindingFlags, bindingFlags->pBindingFlags + bindingFlags->bindingCount);
+	}
+	
+	std::vector<CachedDescriptorSetLayoutEntry> &bucket = descriptorSetLayoutCache[hash];
+	for(const CachedDescriptorSetLayoutEntry &cached : bucket){
+		if(cached.flags != entry.flags || cached.bindingFlags != entry.bindingFlags || cached.bindings.size() != entry.bindings.size()){
+			continue;
+		}
+		if(std::equal(cached.bindings.begin(), cached.bindings.end(), entry.bindings.begin(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b){
+			return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags && a.pImmutableSamplers == b.pImmutableSamplers;
+		})){
+			return cached.handle;
+		}
+	}
+	if(vkCreateDescriptorSetLayout(logicalDevice, &createInfo, nullptr, &entry.handle) != VK_SUCCESS){
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+	bucket.push_back(std::move(entry));
+	return bucket.back().handle;
+}
+
+VkPipelineLayout Devices::CachedPipelineLayout(const VkPipelineLayoutCreateInfo &createInfo){
+	CachedPipelineLayoutEntry entry{
+		.setLayouts = std::vector<VkDescriptorSetLayout>(createInfo.pSetLayouts, createInfo.pSetLayouts + createInfo.setLayoutCount),
+		.pushConstantRanges = std::vector<VkPushConstantRange>(createInfo.pPushConstantRanges, createInfo.pPushConstantRanges + createInfo.pushConstantRangeCount)
+	};
+	// identical descriptor set layouts are already the same handles (see `CachedDescriptorSetLayout`)
+	uint64_t hash = HashCombine(hashSeed, entry.setLayouts.size());
+	for(VkDescriptorSetLayout setLayout : entry.setLayouts){
+		hash = HashCombine(hash, std::hash<VkDescriptorSetLayout>{}(setLayout));
+	}
+	for(const VkPushConstantRange &range : entry.pushConstantRanges){
+		hash = HashCombine(HashCombine(HashCombine(hash, range.stageFlags), range.offset), range.size);
+	}
+	
+	std::vector<CachedPipelineLayoutEntry> &bucket = pipelineLayoutCache[hash];
+	for(const CachedPipelineLayoutEntry &cached : bucket){
+		if(cached.setLayouts != entry.setLayouts || cached.pushConstantRanges.size() != entry.pushConstantRanges.size()){
+			continue;
+		}
+		if(std::equal(cached.pushConstantRanges.begin(), cached.pushConstantRanges.end(), entry.pushConstantRanges.begin(), [](const VkPushConstantRange &a, const VkPushConstantRange &b){
+			return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+		})){
+			return cached.handle;
+		}
+	}
+	if(vkCreatePipelineLayout(logicalDevice, &createInfo, nullptr, &entry.handle) != VK_SUCCESS){
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+	bucket.push_back(std::move(entry));
+	return bucket.back().handle;
+}
+
 VkCommandBuffer Devices::BeginSingleTimeCommands() const {
 	const VkCommandBufferAllocateInfo allocInfo{
 		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -419,7 +711,44 @@ VkFormat Devices::FindDepthFormat() const {
 							   VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
 }
 
-void Devices::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo *allocationInfoDst) const {
+std::optional<Devices::DescriptorBufferRegion> Devices::AllocateDescriptorBufferRegion(VkDeviceSize size){
+	const VmaVirtualAllocationCreateInfo allocationCI{
+		.size = std::max(size, VkDeviceSize(1)),
+		.alignment = descriptorBufferProperties.descriptorBufferOffsetAlignment
+	};
+	DescriptorBufferRegion ret;
+	if(vmaVirtualAllocate(descriptorBufferBlock, &allocationCI, &ret.allocation, &ret.offset) != VK_SUCCESS){
+		return {};
+	}
+	return ret;
+}
+void Devices::FreeDescriptorBufferRegion(const DescriptorBufferRegion &region){
+	EnqueueDestruction([block = descriptorBufferBlock, allocation = region.allocation](){
+		vmaVirtualFree(block, allocation);
+	});
+}
+size_t Devices::DescriptorSize(VkDescriptorType type) const {
+	switch(type){
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			return descriptorBufferProperties.samplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return descriptorBufferProperties.combinedImageSamplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			return descriptorBufferProperties.sampledImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			return descriptorBufferProperties.storageImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return descriptorBufferProperties.inputAttachmentDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			return descriptorBufferProperties.uniformBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			return descriptorBufferProperties.storageBufferDescriptorSize;
+		default:
+			throw std::runtime_error("descriptor type cannot be used in a descriptor buffer!");
+	}
+}
+
+void Devices::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo *allocationInfoDst, VkMemoryPropertyFlags preferredProperties) const {
 	/*
 	 VkBufferCreateInfo bufferInfo{};
 	 // creating buffer
@@ -444,22 +773,94 @@ void Devices::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemory
 	VkBufferCreateInfo bufferInfo{
 		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
 		.size = size,
-		.usage = usage,
+		.usage = AddressableUsage(usage),
 		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
 	};
 	VmaAllocationCreateInfo allocInfo = {
 		.usage = VMA_MEMORY_USAGE_AUTO,
-		.requiredFlags = properties
+		.requiredFlags = properties,
+		.preferredFlags = preferredProperties
 	};
 	if(allocationInfoDst){
 		allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		// the caller hasn't asked for host visible memory, so it must be prepared to find `pMappedData` null
+		if(!(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)){
+			allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
+		}
 	}
 	if(vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, &buffer, &allocation, allocationInfoDst) != VK_SUCCESS){
 		throw std::runtime_error("failed to create buffer!");
 	}
 }
 
-void Devices::CreateImage(const VkImageCreateInfo &imageCI, /*uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,*/ VkMemoryPropertyFlags properties, VkImage &image, VmaAllocation &allocation) const {
+bool Devices::ImportHostBuffer(void *hostPointer, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory) const {
+	if(!SupportsHostMemoryImport()){
+		std::cout << "Cannot import host memory; VK_EXT_external_memory_host is not supported.\n";
+		return false;
+	}
+	if(reinterpret_cast<uintptr_t>(hostPointer) % hostImportAlignment || size % hostImportAlignment){
+		std::cout << "Cannot import host memory; pointer and size must be multiples of " << hostImportAlignment << ".\n";
+		return false;
+	}
+	
+	VkMemoryHostPointerPropertiesEXT pointerProperties{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT
+	};
+	if(getMemoryHostPointerProperties(logicalDevice, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, hostPointer, &pointerProperties) != VK_SUCCESS){
+		std::cout << "Cannot import host memory; the pointer is not importable.\n";
+		return false;
+	}
+	
+	const VkExternalMemoryBufferCreateInfo externalCI{
+		.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+		.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT
+	};
+	const VkBufferCreateInfo bufferCI{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.pNext = &externalCI,
+		.size = size,
+		.usage = AddressableUsage(usage),
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+	};
+	if(vkCreateBuffer(logicalDevice, &bufferCI, nullptr, &buffer) != VK_SUCCESS){
+		throw std::runtime_error("failed to create buffer!");
+	}
+	
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(logicalDevice, buffer, &memRequirements);
+	const uint32_t typeBits = memRequirements.memoryTypeBits & pointerProperties.memoryTypeBits;
+	if(!typeBits){
+		std::cout << "Cannot import host memory; no memory type is usable by both the buffer and the pointer.\n";
+		vkDestroyBuffer(logicalDevice, buffer, nullptr);
+		return false;
+	}
+	
+	// memory bound to an addressable buffer must be allocated as such
+	const VkMemoryAllocateFlagsInfo allocateFlags{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+		.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+	};
+	const VkImportMemoryHostPointerInfoEXT importInfo{
+		.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+		.pNext = AddressableUsage(usage) & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT ? &allocateFlags : nullptr,
+		.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+		.pHostPointer = hostPointer
+	};
+	const VkMemoryAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		.pNext = &importInfo,
+		.allocationSize = size,
+		.memoryTypeIndex = FindMemoryType(typeBits, 0)
+	};
+	if(vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS){
+		std::cout << "Cannot import host memory; allocation failed.\n";
+		vkDestroyBuffer(logicalDevice, buffer, nullptr);
+		return false;
+	}
+	vkBindBufferMemory(logicalDevice, buffer, memory, 0);
+	return true;
+}
+void Devices::CreateImage(const VkImageCreateInfo &imageCI, /*uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,*/ VkMemoryPropertyFlags properties, VkImage &image, VmaAllocation &allocation, bool dedicated) const {
 	
 	/*
 	 VkImageCreateInfo imageInfo{};
@@ -500,7 +901,7 @@ void Devices::CreateImage(const VkImageCreateInfo &imageCI, /*uint32_t width, ui
 	const VmaAllocationCreateInfo allocInfo = {
 		.usage = VMA_MEMORY_USAGE_AUTO,
 		.requiredFlags = properties,
-		.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+		.flags = dedicated ? VmaAllocationCreateFlags(VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) : VmaAllocationCreateFlags(0), // dedicated allocations cannot be moved by the defragmenter
 		.priority = 1.0f
 	};
 	if(const VkResult res = vmaCreateImage(allocator, &imageCI, &allocInfo, &image, &allocation, nullptr);
@@ -528,60 +929,89 @@ VkImageView Devices::CreateImageView(const VkImageViewCreateInfo &imageViewCI/*V
 	return ret;
 }
 
+bool Devices::CreateDeviceLocalBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo &allocationInfo) const {
+	const VkBufferCreateInfo bufferInfo{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.size = size,
+		.usage = AddressableUsage(usage),
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+	};
+	// if there is mappable device local memory VMA will choose it, otherwise we get plain device local memory and have to stage
+	const VmaAllocationCreateInfo allocInfo = {
+		.flags = hostVisibleDeviceLocalMemory ? VmaAllocationCreateFlags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT) : VmaAllocationCreateFlags(0),
+		.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+		.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+	};
+	if(vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, &buffer, &allocation, &allocationInfo) != VK_SUCCESS){
+		throw std::runtime_error("failed to create buffer!");
+	}
+	return allocationInfo.pMappedData != nullptr;
+}
 void Devices::CreateAndFillDeviceLocalBuffer(VkBuffer &bufferHandle, VmaAllocation &allocation, const std::vector<DeviceMemory> &memory, const VkBufferUsageFlags &usageFlags) const {
 	VkDeviceSize totalSize = 0;
 	for(const DeviceMemory &dm : memory){
 		totalSize += dm.size;
 	}
+	CreateAndFillDeviceLocalBuffer(bufferHandle, allocation, totalSize, DeviceMemoriesWriter(memory), usageFlags);
+}
+void Devices::CreateAndFillDeviceLocalBuffer(VkBuffer &bufferHandle, VmaAllocation &allocation, VkDeviceSize size, const MemoryWriter &writer, const VkBufferUsageFlags &usageFlags) const {
+	// creating the new buffer
+	VmaAllocationInfo allocationInfo;
+	if(CreateDeviceLocalBuffer(size,
+							   VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | usageFlags, // usage; transfer source so the defragmenter can copy it elsewhere
+							   bufferHandle,
+							   allocation,
+							   allocationInfo)){
+		// mappable; writing directly
+		writer({static_cast<std::byte *>(allocationInfo.pMappedData), size_t(size)});
+		vmaFlushAllocation(allocator, allocation, 0, VK_WHOLE_SIZE);
+		return;
+	}
+	
 	// creating staging buffer
 	VkBuffer stagingBuffer;
 	VmaAllocation stagingAllocation;
 	VmaAllocationInfo stagingAllocInfo;
-	CreateBuffer(totalSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation, &stagingAllocInfo);
-	
-	VkDeviceSize offset = 0;
-	for(const DeviceMemory &dm : memory){
-		memcpy(static_cast<void *>((char *)stagingAllocInfo.pMappedData + offset), dm.ptr, (size_t)dm.size);
-		offset += dm.size;
-	}
+	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation, &stagingAllocInfo);
+	writer({static_cast<std::byte *>(stagingAllocInfo.pMappedData), size_t(size)});
 	vmaFlushAllocation(allocator, stagingAllocation, 0, VK_WHOLE_SIZE);
 	
-	// creating the new vertex buffer
-	CreateBuffer(totalSize, // size
-				 VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags, // usage
-				 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, // properties; device local means we generally can't use 'vkMapMemory', but it is quicker to access by the GPU
-				 bufferHandle, // buffer handle output
-				 allocation); // buffer memory handle output
-	// copying the contents of the staging buffer into the vertex buffer
-	CopyBuffer(stagingBuffer, bufferHandle, totalSize);
+	// copying the contents of the staging buffer into the new buffer
+	CopyBuffer(stagingBuffer, bufferHandle, size);
 	// cleaning up staging buffer
 	vmaDestroyBuffer(allocator, stagingBuffer, stagingAllocation);
 }
-
-void Devices::FillExistingDeviceLocalBuffer(VkBuffer bufferHandle, const std::vector<DeviceMemory> &memory) const {
+void Devices::FillExistingDeviceLocalBuffer(VkBuffer bufferHandle, VmaAllocation allocation, const std::vector<DeviceMemory> &memory) const {
 	VkDeviceSize totalSize = 0;
 	for(const DeviceMemory &dm : memory){
 		totalSize += dm.size;
 	}
+	FillExistingDeviceLocalBuffer(bufferHandle, allocation, totalSize, DeviceMemoriesWriter(memory));
+}
+void Devices::FillExistingDeviceLocalBuffer(VkBuffer bufferHandle, VmaAllocation allocation, VkDeviceSize size, const MemoryWriter &writer, VkDeviceSize dstOffset) const {
+	VmaAllocationInfo allocationInfo;
+	vmaGetAllocationInfo(allocator, allocation, &allocationInfo);
+	if(allocationInfo.pMappedData){
+		// the staged copy below would be queued behind any submitted frames, so we have to wait for them before writing directly
+		vkQueueWaitIdle(graphicsQueue);
+		writer({static_cast<std::byte *>(allocationInfo.pMappedData) + dstOffset, size_t(size)});
+		vmaFlushAllocation(allocator, allocation, dstOffset, size);
+		return;
+	}
+	
 	// creating staging buffer
 	VkBuffer stagingBuffer;
 	VmaAllocation stagingAllocation;
 	VmaAllocationInfo stagingAllocInfo;
-	CreateBuffer(totalSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation, &stagingAllocInfo);
-	
-	VkDeviceSize offset = 0;
-	for(const DeviceMemory &dm : memory){
-		memcpy(static_cast<void *>((char *)stagingAllocInfo.pMappedData + offset), dm.ptr, (size_t)dm.size);
-		offset += dm.size;
-	}
+	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation, &stagingAllocInfo);
+	writer({static_cast<std::byte *>(stagingAllocInfo.pMappedData), size_t(size)});
 	vmaFlushAllocation(allocator, stagingAllocation, 0, VK_WHOLE_SIZE);
 	
-	// copying the contents of the staging buffer into the vertex buffer
-	CopyBuffer(stagingBuffer, bufferHandle, totalSize);
+	// copying the contents of the staging buffer into the existing buffer
+	CopyBuffer(stagingBuffer, bufferHandle, size, 0, dstOffset);
 	// cleaning up staging buffer
 	vmaDestroyBuffer(allocator, stagingBuffer, stagingAllocation);
 }
-
 void Devices::GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) const {
 	// Check if image format supports linear blitting
 	VkFormatProperties formatProperties;
@@ -665,12 +1095,12 @@ void Devices::GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWi
 	EndSingleTimeCommands(commandBuffer);
 }
 
-void Devices::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const {
+void Devices::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) const {
 	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
 	
 	VkBufferCopy copyRegion{};
-	copyRegion.srcOffset = 0; // Optional
-	copyRegion.dstOffset = 0; // Optional
+	copyRegion.srcOffset = srcOffset;
+	copyRegion.dstOffset = dstOffset;
 	copyRegion.size = size;
 	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 	
@@ -678,7 +1108,10 @@ void Devices::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize si
 }
 void Devices::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subResourceRange) const {
 	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-	
+	CmdTransitionImageLayout(commandBuffer, image, format, oldLayout, newLayout, subResourceRange);
+	EndSingleTimeCommands(commandBuffer);
+}
+void Devices::CmdTransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subResourceRange) const {
 	VkImageMemoryBarrier barrier {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
 		.oldLayout = oldLayout,
@@ -713,8 +1146,6 @@ void Devices::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayou
 						 0, nullptr,
 						 0, nullptr,
 						 1, &barrier);
-	
-	EndSingleTimeCommands(commandBuffer);
 }
 void Devices::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t depth) const {
 	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
@@ -741,4 +1172,40 @@ void Devices::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
 	EndSingleTimeCommands(commandBuffer);
 }
 
+void Devices::ExecuteDestructions(uint64_t completedFrame){
+	// entries are in order of frame
+	while(!pendingDestructions.empty() && pendingDestructions.front().frame <= completedFrame){
+		// popping first, so that destructions can enqueue more destructions
+		const std::function<void()> destroy = std::move(pendingDestructions.front().destroy);
+		pendingDestructions.pop_front();
+		destroy();
+	}
+}
+
+VkBuffer Devices::CmdRelocateBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkDeviceSize size, VkBufferUsageFlags usage, VmaAllocation dstAllocation) const {
+	const VkBufferCreateInfo bufferInfo{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.size = size,
+		.usage = AddressableUsage(usage),
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+	};
+	VkBuffer ret;
+	if(vkCreateBuffer(logicalDevice, &bufferInfo, nullptr, &ret) != VK_SUCCESS){
+		return VK_NULL_HANDLE;
+	}
+	if(vmaBindBufferMemory(allocator, dstAllocation, ret) != VK_SUCCESS){
+		vkDestroyBuffer(logicalDevice, ret, nullptr);
+		return VK_NULL_HANDLE;
+	}
+	
+	const VkBufferCopy copyRegion{
+		.srcOffset = 0,
+		.dstOffset = 0,
+		.size = size
+	};
+	vkCmdCopyBuffer(commandBuffer, srcBuffer, ret, 1, &copyRegion);
+	
+	return ret;
+}
+
 } // namespace::EVK
@@ -0,0 +1,205 @@
+#include <vma/vk_mem_alloc.h>
+
+#include <algorithm>
+
+#include <GeometryPool.hpp>
+
+namespace EVK {
+
+GeometryPool::GeometryPool(std::shared_ptr<Devices> _devices,
+						   uint32_t _vertexStride,
+						   uint32_t _vertexCapacity,
+						   uint32_t _indexCapacity,
+						   VkIndexType _indexType,
+						   VkBufferUsageFlags extraUsages)
+: devices(std::move(_devices)),
+vertexStride(_vertexStride),
+vertexCapacity(_vertexCapacity),
+indexCapacity(_indexCapacity),
+indexType(_indexType),
+indexSize(_indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4),
+vertexUsage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | extraUsages),
+indexUsage(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | extraUsages) {
+	if(vertexStride == 0 || vertexCapacity == 0 || indexCapacity == 0){
+		throw std::runtime_error("Geometry pool stride and capacities cannot be zero.");
+	}
+	CreateBuffers();
+}
+
+GeometryPool::~GeometryPool(){
+	DestroyBuffers();
+}
+
+void GeometryPool::CreateBuffers(){
+	VmaAllocationInfo allocationInfo;
+	devices->CreateDeviceLocalBuffer(VkDeviceSize(vertexCapacity) * vertexStride, vertexUsage, vertexBuffer, vertexAllocation, allocationInfo);
+	devices->CreateDeviceLocalBuffer(VkDeviceSize(indexCapacity) * indexSize, indexUsage, indexBuffer, indexAllocation, allocationInfo);
+	
+	// the virtual blocks are measured in vertices and indices rather than bytes
+	const VmaVirtualBlockCreateInfo vertexBlockCI{
+		.size = vertexCapacity
+	};
+	const VmaVirtualBlockCreateInfo indexBlockCI{
+		.size = indexCapacity
+	};
+	if(vmaCreateVirtualBlock(&vertexBlockCI, &vertexBlock) != VK_SUCCESS || vmaCreateVirtualBlock(&indexBlockCI, &indexBlock) != VK_SUCCESS){
+		throw std::runtime_error("failed to create geometry pool virtual blocks!");
+	}
+}
+
+void GeometryPool::DestroyBuffers(){
+	// frames in flight may still be drawing from the buffers, but the virtual blocks are only used by the host
+	vmaClearVirtualBlock(vertexBlock);
+	vmaDestroyVirtualBlock(vertexBlock);
+	vmaClearVirtualBlock(indexBlock);
+	vmaDestroyVirtualBlock(indexBlock);
+	devices->EnqueueDestruction([allocator = devices->GetAllocator(), vertexBuffer = vertexBuffer, vertexAllocation = vertexAllocation, indexBuffer = indexBuffer, indexAllocation = indexAllocation](){
+		vmaDestroyBuffer(allocator, vertexBuffer, vertexAllocation);
+		vmaDestroyBuffer(allocator, indexBuffer, indexAllocation);
+	});
+}
+
+bool GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount, Entry &entry){
+	const VmaVirtualAllocationCreateInfo vertexCI{
+		.size = vertexCount
+	};
+	VkDeviceSize vertexOffset;
+	if(vmaVirtualAllocate(vertexBlock, &vertexCI, &entry.vertexRange, &vertexOffset) != VK_SUCCESS){
+		return false;
+	}
+	const VmaVirtualAllocationCreateInfo indexCI{
+		.size = indexCount
+	};
+	VkDeviceSize indexOffset;
+	if(vmaVirtualAllocate(indexBlock, &indexCI, &entry.indexRange, &indexOffset) != VK_SUCCESS){
+		vmaVirtualFree(vertexBlock, entry.vertexRange);
+		return false;
+	}
+	entry.mesh = {
+		.indexCount = indexCount,
+		.firstIndex = uint32_t(indexOffset),
+		.vertexOffset = int32_t(vertexOffset),
+		.vertexCount = vertexCount
+	};
+	return true;
+}
+
+std::optional<GeometryPool::MeshID> GeometryPool::Add(uint32_t vertexCount, const Devices::MemoryWriter &vertexWriter, uint32_t indexCount, const Devices::MemoryWriter &indexWriter){
+	if(vertexCount == 0 || indexCount == 0){
+		std::cout << "Cannot add mesh to geometry pool; it is empty.\n";
+		return {};
+	}
+	
+	ReleasePendingFrees();
+	
+	Entry entry;
+	if(!Allocate(vertexCount, indexCount, entry)){
+		// there may be enough space in total, just fragmented or waiting to be freed
+		uint64_t liveVertices = 0, liveIndices = 0;
+		for(const auto &[id, live] : entries){
+			liveVertices += live.mesh.vertexCount;
+			liveIndices += live.mesh.indexCount;
+		}
+		if(vertexCapacity - liveVertices < vertexCount || indexCapacity - liveIndices < indexCount){
+			std::cout << "Cannot add mesh to geometry pool; it is full.\n";
+			return {};
+		}
+		Compact();
+		if(!Allocate(vertexCount, indexCount, entry)){
+			std::cout << "Cannot add mesh to geometry pool; it is full.\n";
+			return {};
+		}
+	}
+	
+	devices->FillExistingDeviceLocalBuffer(vertexBuffer, vertexAllocation, VkDeviceSize(vertexCount) * vertexStride, vertexWriter, VkDeviceSize(entry.mesh.vertexOffset) * vertexStride);
+	devices->FillExistingDeviceLocalBuffer(indexBuffer, indexAllocation, VkDeviceSize(indexCount) * indexSize, indexWriter, VkDeviceSize(entry.mesh.firstIndex) * indexSize);
+	
+	const MeshID id = nextID++;
+	entries[id] = entry;
+	return id;
+}
+
+std::optional<GeometryPool::MeshID> GeometryPool::Add(const std::vector<Devices::DeviceMemory> &vertexMemory, const std::vector<Devices::DeviceMemory> &indexMemory){
+	VkDeviceSize vertexBytes = 0;
+	for(const Devices::DeviceMemory &dm : vertexMemory){
+		vertexBytes += dm.size;
+	}
+	VkDeviceSize indexBytes = 0;
+	for(const Devices::DeviceMemory &dm : indexMemory){
+		indexBytes += dm.size;
+	}
+	return Add(uint32_t(vertexBytes / vertexStride), Devices::DeviceMemoriesWriter(vertexMemory), uint32_t(indexBytes / indexSize), Devices::DeviceMemoriesWriter(indexMemory));
+}
+
+void GeometryPool::Remove(MeshID id){
+	const auto it = entries.find(id);
+	if(it == entries.end()){
+		std::cout << "Cannot remove mesh from geometry pool; no such mesh.\n";
+		return;
+	}
+	// the space is not reused until frames in flight that may be drawing the mesh have finished
+	pendingFrees.push_back({devices->FrameTimeline(), it->second.vertexRange, it->second.indexRange});
+	entries.erase(it);
+}
+
+void GeometryPool::ReleasePendingFrees(){
+	// frames up to `FrameTimeline() - MAX_FRAMES_IN_FLIGHT` have finished executing (see `EVK::Interface::BeginFrame`)
+	const uint64_t timeline = devices->FrameTimeline();
+	std::erase_if(pendingFrees, [&](const PendingFree &pending){
+		if(pending.frame + MAX_FRAMES_IN_FLIGHT > timeline){
+			return false;
+		}
+		vmaVirtualFree(vertexBlock, pending.vertexRange);
+		vmaVirtualFree(indexBlock, pending.indexRange);
+		return true;
+	});
+}
+
+void GeometryPool::Compact(){
+	const VkBuffer oldVertexBuffer = vertexBuffer;
+	const VkBuffer oldIndexBuffer = indexBuffer;
+	DestroyBuffers();
+	CreateBuffers();
+	// removed meshes are not copied, and frames in flight still drawing them use the old buffers
+	pendingFrees.clear();
+	
+	// re-allocating the live meshes in their current order, so they are packed from the start
+	std::vector<Entry *> ordered {};
+	ordered.reserve(entries.size());
+	for(auto &[id, entry] : entries){
+		ordered.push_back(&entry);
+	}
+	std::ranges::sort(ordered, [](const Entry *a, const Entry *b){ return a->mesh.vertexOffset < b->mesh.vertexOffset; });
+	
+	std::vector<VkBufferCopy> vertexCopies {};
+	std::vector<VkBufferCopy> indexCopies {};
+	vertexCopies.reserve(ordered.size());
+	indexCopies.reserve(ordered.size());
+	for(Entry *entry : ordered){
+		const Mesh old = entry->mesh;
+		if(!Allocate(old.vertexCount, old.indexCount, *entry)){
+			throw std::runtime_error("failed to re-allocate mesh while compacting geometry pool!");
+		}
+		vertexCopies.push_back({
+			.srcOffset = VkDeviceSize(old.vertexOffset) * vertexStride,
+			.dstOffset = VkDeviceSize(entry->mesh.vertexOffset) * vertexStride,
+			.size = VkDeviceSize(old.vertexCount) * vertexStride
+		});
+		indexCopies.push_back({
+			.srcOffset = VkDeviceSize(old.firstIndex) * indexSize,
+			.dstOffset = VkDeviceSize(entry->mesh.firstIndex) * indexSize,
+			.size = VkDeviceSize(old.indexCount) * indexSize
+		});
+	}
+	if(ordered.empty()){
+		return;
+	}
+	
+	// the old buffers are destroyed through the deferred destruction queue, so are still valid here
+	VkCommandBuffer commandBuffer = devices->BeginSingleTimeCommands();
+	vkCmdCopyBuffer(commandBuffer, oldVertexBuffer, vertexBuffer, uint32_t(vertexCopies.size()), vertexCopies.data());
+	vkCmdCopyBuffer(commandBuffer, oldIndexBuffer, indexBuffer, uint32_t(indexCopies.size()), indexCopies.data());
+	devices->EndSingleTimeCommands(commandBuffer);
+}
+
+} // namespace EVK
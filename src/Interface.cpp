@@ -442,6 +442,11 @@ std::optional<CommandEnvironment> Interface::BeginFrame(){
 	// waiting until previous frame has finished rendering
 	vkWaitForFences(devices->GetLogicalDevice(), 1, &inFlightFencesFlying[currentFrame], VK_TRUE, UINT64_MAX);
 	
+	// the frame that last used this flight has finished, so objects released during or before it can now be destroyed
+	if(devices->FrameTimeline() >= MAX_FRAMES_IN_FLIGHT){
+		devices->ExecuteDestructions(devices->FrameTimeline() - MAX_FRAMES_IN_FLIGHT);
+	}
+	
 	// acquiring an image from the swap chain
 	VkResult result = vkAcquireNextImageKHR(devices->GetLogicalDevice(), swapChain, UINT64_MAX, imageAvailableSemaphoresFlying[currentFrame], VK_NULL_HANDLE, &currentFrameImageIndex);
 	
@@ -468,6 +473,10 @@ std::optional<CommandEnvironment> Interface::BeginFrame(){
 	if(vkBeginCommandBuffer(commandBuffersFlying[currentFrame], &beginInfo) != VK_SUCCESS){
 		throw std::runtime_error("failed to begin recording command buffer!");
 	}
+	// bound once here, so binding sets of pipelines using descriptor buffers only sets offsets
+	if(devices->UsesDescriptorBuffers()){
+		devices->CmdBindDescriptorBuffer(commandBuffersFlying[currentFrame]);
+	}
 	
 	return CommandEnvironment{commandBuffersFlying[currentFrame], currentFrame};
 }
@@ -511,18 +520,14 @@ void Interface::EndFrame(std::optional<VkPipelineStageFlags> stagesWaitForComput
 		throw std::runtime_error("failed to record command buffer!");
 	}
 	
-	// submitting the command buffer to the graphics queue
-	std::vector<VkSemaphore> waitSemaphores = {imageAvailableSemaphoresFlying[currentFrame]};
-	std::vector<VkPipelineStageFlags> waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	if(stagesWaitForCompute){
-		waitSemaphores.push_back(computeFinishedSemaphoresFlying[currentFrame]);
-		waitStages.push_back(stagesWaitForCompute.value());
-	}
+	// submitting the command buffer to the graphics queue; the second wait is only used when waiting for compute
+	const std::array<VkSemaphore, 2> waitSemaphores = {imageAvailableSemaphoresFlying[currentFrame], computeFinishedSemaphoresFlying[currentFrame]};
+	const std::array<VkPipelineStageFlags, 2> waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, stagesWaitForCompute.value_or(0)};
 	VkSemaphore signalSemaphores[1] = {renderFinishedSemaphoresFlying[currentFrame]};
 	
 	const VkSubmitInfo submitInfo{
 		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-		.waitSemaphoreCount = uint32_t(waitSemaphores.size()),
+		.waitSemaphoreCount = stagesWaitForCompute ? 2u : 1u,
 		.pWaitSemaphores = waitSemaphores.data(),
 		.pWaitDstStageMask = waitStages.data(),
 		.commandBufferCount = 1,
@@ -533,6 +538,7 @@ void Interface::EndFrame(std::optional<VkPipelineStageFlags> stagesWaitForComput
 	if(vkQueueSubmit(devices->GraphicsQueue(), 1, &submitInfo, inFlightFencesFlying[currentFrame]) != VK_SUCCESS){
 		throw std::runtime_error("failed to submit draw command buffer!");
 	}
+	devices->AdvanceFrameTimeline();
 	
 	// presenting on the present queue
 	VkSwapchainKHR swapChains[] = {swapChain};
@@ -570,6 +576,9 @@ CommandEnvironment Interface::BeginCompute(){
 	if (vkBeginCommandBuffer(computeCommandBuffersFlying[currentFrame], &beginInfo) != VK_SUCCESS){
 		throw std::runtime_error("failed to begin recording compute command buffer!");
 	}
+	if(devices->UsesDescriptorBuffers()){
+		devices->CmdBindDescriptorBuffer(computeCommandBuffersFlying[currentFrame]);
+	}
 	
 	return CommandEnvironment{
 		.commandBuffer = computeCommandBuffersFlying[currentFrame],
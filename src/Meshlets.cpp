@@ -0,0 +1,154 @@
+#include <vma/vk_mem_alloc.h>
+
+#include <cmath>
+
+#include <Meshlets.hpp>
+
+namespace EVK {
+
+namespace {
+
+using Vec3 = std::array<float, 3>;
+
+Vec3 Sub(const Vec3 &a, const Vec3 &b){ return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+float Dot(const Vec3 &a, const Vec3 &b){ return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+Vec3 Cross(const Vec3 &a, const Vec3 &b){ return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]}; }
+
+// bounding sphere and normal cone of the meshlet's triangles
+void CalculateBounds(Meshlet &meshlet, const std::vector<Vec3> &positions, const MeshletData &data){
+	Vec3 min = positions[data.vertices[meshlet.vertexOffset]];
+	Vec3 max = min;
+	for(uint32_t i=1; i<meshlet.vertexCount; ++i){
+		const Vec3 &p = positions[data.vertices[meshlet.vertexOffset + i]];
+		for(int j=0; j<3; ++j){
+			min[j] = std::min(min[j], p[j]);
+			max[j] = std::max(max[j], p[j]);
+		}
+	}
+	const Vec3 centre = {0.5f * (min[0] + max[0]), 0.5f * (min[1] + max[1]), 0.5f * (min[2] + max[2])};
+	float radiusSquared = 0.0f;
+	for(uint32_t i=0; i<meshlet.vertexCount; ++i){
+		const Vec3 d = Sub(positions[data.vertices[meshlet.vertexOffset + i]], centre);
+		radiusSquared = std::max(radiusSquared, Dot(d, d));
+	}
+	meshlet.boundingSphere = {centre[0], centre[1], centre[2], std::sqrt(radiusSquared)};
+	
+	// the cone axis is the average of the triangles' normals, and it is as wide as the normal furthest from it
+	std::vector<Vec3> normals {};
+	normals.reserve(meshlet.triangleCount);
+	Vec3 axis = {0.0f, 0.0f, 0.0f};
+	for(uint32_t t=0; t<meshlet.triangleCount; ++t){
+		const uint32_t *triangle = &data.indices[3 * (meshlet.triangleOffset + t)];
+		const Vec3 normal = Cross(Sub(positions[triangle[1]], positions[triangle[0]]), Sub(positions[triangle[2]], positions[triangle[0]]));
+		const float length = std::sqrt(Dot(normal, normal));
+		if(length == 0.0f){
+			continue;
+		}
+		normals.push_back({normal[0] / length, normal[1] / length, normal[2] / length});
+		for(int j=0; j<3; ++j){
+			axis[j] += normals.back()[j];
+		}
+	}
+	const float axisLength = std::sqrt(Dot(axis, axis));
+	if(normals.empty() || axisLength == 0.0f){
+		meshlet.cone = {0.0f, 0.0f, 0.0f, 1.0f};
+		return;
+	}
+	axis = {axis[0] / axisLength, axis[1] / axisLength, axis[2] / axisLength};
+	float minDot = 1.0f;
+	for(const Vec3 &normal : normals){
+		minDot = std::min(minDot, Dot(normal, axis));
+	}
+	// a cone of 90 degrees or wider is never entirely back facing
+	meshlet.cone = {axis[0], axis[1], axis[2], minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot)};
+}
+
+} // namespace
+
+MeshletData BuildMeshlets(const std::byte *vertices, uint32_t vertexCount, uint32_t vertexStride, uint32_t positionOffset, std::span<const uint32_t> indices, uint32_t maxVertices, uint32_t maxTriangles){
+	if(maxVertices < 3 || maxVertices > 256 || maxTriangles < 1){
+		throw std::runtime_error("Meshlets must allow 3 to 256 vertices and at least 1 triangle.");
+	}
+	
+	std::vector<Vec3> positions(vertexCount);
+	for(uint32_t i=0; i<vertexCount; ++i){
+		memcpy(positions[i].data(), vertices + size_t(i) * vertexStride + positionOffset, sizeof(Vec3));
+	}
+	
+	MeshletData ret {};
+	ret.indices.reserve(indices.size());
+	ret.triangles.reserve(indices.size());
+	
+	// the current meshlet's local index of each mesh vertex, or -1
+	std::vector<int32_t> localIndices(vertexCount, -1);
+	Meshlet current {};
+	const auto finish = [&](){
+		if(current.triangleCount == 0){
+			return;
+		}
+		CalculateBounds(current, positions, ret);
+		ret.meshlets.push_back(current);
+		for(uint32_t i=0; i<current.vertexCount; ++i){
+			localIndices[ret.vertices[current.vertexOffset + i]] = -1;
+		}
+		current = {
+			.vertexOffset = uint32_t(ret.vertices.size()),
+			.triangleOffset = uint32_t(ret.indices.size() / 3)
+		};
+	};
+	
+	for(size_t t=0; t + 2<indices.size(); t+=3){
+		uint32_t newVertices = 0;
+		for(int j=0; j<3; ++j){
+			if(indices[t + j] >= vertexCount){
+				throw std::runtime_error("Meshlet index out of range of the vertices.");
+			}
+			newVertices += localIndices[indices[t + j]] < 0 ? 1 : 0;
+		}
+		if(current.vertexCount + newVertices > maxVertices || current.triangleCount + 1 > maxTriangles){
+			finish();
+		}
+		for(int j=0; j<3; ++j){
+			const uint32_t index = indices[t + j];
+			if(localIndices[index] < 0){
+				localIndices[index] = int32_t(current.vertexCount++);
+				ret.vertices.push_back(index);
+			}
+			ret.indices.push_back(index);
+			ret.triangles.push_back(uint8_t(localIndices[index]));
+		}
+		current.triangleCount++;
+	}
+	finish();
+	
+	return ret;
+}
+
+MeshletBuffers UploadMeshlets(const std::shared_ptr<Devices> &devices, const MeshletData &data){
+	if(data.meshlets.empty()){
+		throw std::runtime_error("Cannot upload zero meshlets.");
+	}
+	
+	// the data is never modified, so one copy serves every flight
+	const auto upload = [&](const void *source, VkDeviceSize size){
+		std::shared_ptr<StorageBufferObject> ret = std::make_shared<StorageBufferObject>(devices, size, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, FlightReplication::STATIC);
+		if(!ret->Fill([&](std::span<std::byte> dst){
+			memcpy(dst.data(), source, dst.size());
+		})){
+			throw std::runtime_error("failed to upload meshlets!");
+		}
+		return ret;
+	};
+	// padded to whole `uint`s
+	const VkDeviceSize triangleBytes = (data.triangles.size() + 3) / 4 * 4;
+	std::vector<uint8_t> triangles = data.triangles;
+	triangles.resize(triangleBytes);
+	return {
+		.meshlets = upload(data.meshlets.data(), data.meshlets.size() * sizeof(Meshlet)),
+		.vertices = upload(data.vertices.data(), data.vertices.size() * sizeof(uint32_t)),
+		.triangles = upload(triangles.data(), triangleBytes),
+		.meshletCount = uint32_t(data.meshlets.size())
+	};
+}
+
+} // namespace EVK
@@ -1,6 +1,7 @@
 #include <vma/vk_mem_alloc.h>
 
 #include <assert.h>
+#include <algorithm>
 
 #include <Resources.hpp>
 
@@ -11,10 +12,13 @@ void VertexBufferObject::Fill(const std::vector<Devices::DeviceMemory> &vertexMe
 	for(const Devices::DeviceMemory &dm : vertexMemory){
 		totalSize += dm.size;
 	}
+	Fill(totalSize, Devices::DeviceMemoriesWriter(vertexMemory), offset);
+}
+void VertexBufferObject::Fill(VkDeviceSize totalSize, const Devices::MemoryWriter &writer, const VkDeviceSize &offset){
 	// destroying old vertex buffer if it exists
 	if(contents){
-		if(contents->size == totalSize){
-			devices->FillExistingDeviceLocalBuffer(contents->bufferHandle, vertexMemory);
+		if(contents->size == totalSize && !contents->importedMemory){
+			devices->FillExistingDeviceLocalBuffer(contents->bufferHandle, contents->allocation, totalSize, writer);
 			contents->offset = offset;
 			return;
 		} else {
@@ -23,15 +27,59 @@ void VertexBufferObject::Fill(const std::vector<Devices::DeviceMemory> &vertexMe
 	}
 	
 	contents = Contents();
-	devices->CreateAndFillDeviceLocalBuffer(contents->bufferHandle, contents->allocation, vertexMemory, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	devices->CreateAndFillDeviceLocalBuffer(contents->bufferHandle, contents->allocation, totalSize, writer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 	contents->offset = offset;
 	contents->size = totalSize;
+	SetRelocatable(devices->GetAllocator(), contents->allocation);
+}
+bool VertexBufferObject::Import(void *hostPointer, VkDeviceSize size, const VkDeviceSize &offset){
+	CleanUpContents();
+	
+	Contents newContents {
+		.offset = offset,
+		.allocation = nullptr,
+		.size = size
+	};
+	if(!devices->ImportHostBuffer(hostPointer, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, newContents.bufferHandle, newContents.importedMemory)){
+		return false;
+	}
+	contents = newContents;
+	IncrementHandleVersion();
+	return true;
+}
+bool VertexBufferObject::CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation){
+	if(!contents || contents->allocation != srcAllocation){
+		return false;
+	}
+	const VkBuffer newBuffer = devices->CmdRelocateBuffer(commandBuffer, contents->bufferHandle, contents->size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, dstAllocation);
+	if(newBuffer == VK_NULL_HANDLE){
+		return false;
+	}
+	relocatedBuffer = newBuffer;
+	return true;
+}
+void VertexBufferObject::FinishRelocation(VmaAllocation srcAllocation){
+	vkDestroyBuffer(devices->GetLogicalDevice(), contents->bufferHandle, nullptr);
+	contents->bufferHandle = *relocatedBuffer;
+	relocatedBuffer.reset();
+	IncrementHandleVersion();
 }
 void VertexBufferObject::CleanUpContents(){
 	if(!contents){
 		return;
 	}
-	vmaDestroyBuffer(devices->GetAllocator(), contents->bufferHandle, contents->allocation);
+	if(contents->importedMemory){
+		devices->EnqueueDestruction([logicalDevice = devices->GetLogicalDevice(), buffer = contents->bufferHandle, memory = contents->importedMemory](){
+			vkDestroyBuffer(logicalDevice, buffer, nullptr);
+			vkFreeMemory(logicalDevice, memory, nullptr);
+		});
+		contents.reset();
+		return;
+	}
+	UnsetRelocatable(devices->GetAllocator(), contents->allocation);
+	devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = contents->bufferHandle, allocation = contents->allocation](){
+		vmaDestroyBuffer(allocator, buffer, allocation);
+	});
 	contents.reset();
 }
 
@@ -40,10 +88,13 @@ void IndexBufferObject::Fill(size_t indexSize, const std::vector<Devices::Device
 	for(const Devices::DeviceMemory &dm : indexMemory){
 		indexCount += dm.size / indexSize;
 	}
+	Fill(indexSize, indexCount, Devices::DeviceMemoriesWriter(indexMemory), offset);
+}
+void IndexBufferObject::Fill(size_t indexSize, uint32_t indexCount, const Devices::MemoryWriter &writer, const VkDeviceSize &offset){
 	// destroying old vertex buffer if it exists
 	if(contents){
 		if(contents->indexCount == indexCount){
-			devices->FillExistingDeviceLocalBuffer(contents->bufferHandle, indexMemory);
+			devices->FillExistingDeviceLocalBuffer(contents->bufferHandle, contents->allocation, indexCount * indexSize, writer);
 			contents->offset = offset;
 			return;
 		} else {
@@ -52,41 +103,165 @@ void IndexBufferObject::Fill(size_t indexSize, const std::vector<Devices::Device
 	}
 	
 	contents = Contents();
-	devices->CreateAndFillDeviceLocalBuffer(contents->bufferHandle, contents->allocation, indexMemory, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	devices->CreateAndFillDeviceLocalBuffer(contents->bufferHandle, contents->allocation, indexCount * indexSize, writer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 	contents->offset = offset;
 	contents->indexCount = indexCount;
+	contents->size = indexCount * indexSize;
+	SetRelocatable(devices->GetAllocator(), contents->allocation);
+}
+bool IndexBufferObject::CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation){
+	if(!contents || contents->allocation != srcAllocation){
+		return false;
+	}
+	const VkBuffer newBuffer = devices->CmdRelocateBuffer(commandBuffer, contents->bufferHandle, contents->size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, dstAllocation);
+	if(newBuffer == VK_NULL_HANDLE){
+		return false;
+	}
+	relocatedBuffer = newBuffer;
+	return true;
+}
+void IndexBufferObject::FinishRelocation(VmaAllocation srcAllocation){
+	vkDestroyBuffer(devices->GetLogicalDevice(), contents->bufferHandle, nullptr);
+	contents->bufferHandle = *relocatedBuffer;
+	relocatedBuffer.reset();
+	IncrementHandleVersion();
 }
 void IndexBufferObject::CleanUpContents(){
 	if(!contents){
 		return;
 	}
-	vmaDestroyBuffer(devices->GetAllocator(), contents->bufferHandle, contents->allocation);
+	UnsetRelocatable(devices->GetAllocator(), contents->allocation);
+	devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = contents->bufferHandle, allocation = contents->allocation](){
+		vmaDestroyBuffer(allocator, buffer, allocation);
+	});
 	contents.reset();
 }
 
 StorageBufferObject::StorageBufferObject(std::shared_ptr<Devices> _devices,
 										 VkDeviceSize _size,
 										 VkBufferUsageFlags usages,
-										 VkMemoryPropertyFlags memoryProperties)
-: devices(std::move(_devices)), size(_size) {
-	for(size_t i=0; i<MAX_FRAMES_IN_FLIGHT; ++i){
+										 VkMemoryPropertyFlags memoryProperties,
+										 FlightReplication _replication)
+: devices(std::move(_devices)), size(_size), usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usages), replication(_replication) {
+	if((usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) && !devices->SupportsBufferDeviceAddress()){
+		throw std::runtime_error("failed to create storage buffer object; buffer device addresses are not supported!");
+	}
+	if(replication == FlightReplication::PACKED){
+		const VkDeviceSize minSboAlignment = devices->GetPhysicalDeviceProperties().limits.minStorageBufferOffsetAlignment;
+		flightStride = minSboAlignment > 0 ? (size + minSboAlignment - 1) & ~(minSboAlignment - 1) : size;
+	}
+	for(int i=0; i<Copies(); ++i){
 		// creating buffer
-		devices->CreateBuffer(size,
-							  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usages,
+		devices->CreateBuffer(BufferSize(),
+							  usage,
 							  memoryProperties,
 							  buffersFlying[i],
 							  allocationsFlying[i],
 							  &(allocationInfosFlying[i]));
+		SetRelocatable(devices->GetAllocator(), allocationsFlying[i]);
+	}
+}
+
+StorageBufferObject::StorageBufferObject(std::shared_ptr<Devices> _devices,
+										 void *hostPointer,
+										 VkDeviceSize _size,
+										 VkBufferUsageFlags usages)
+: devices(std::move(_devices)), size(_size), usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | usages), replication(FlightReplication::STATIC) {
+	if((usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) && !devices->SupportsBufferDeviceAddress()){
+		throw std::runtime_error("failed to create storage buffer object; buffer device addresses are not supported!");
+	}
+	if(!devices->ImportHostBuffer(hostPointer, size, usage, buffersFlying[0], importedMemory)){
+		throw std::runtime_error("failed to import host memory as a storage buffer!");
+	}
+	// no VMA allocation, so the defragmenter will never try to move this
+	allocationsFlying[0] = nullptr;
+	allocationInfosFlying[0] = {.pMappedData = hostPointer};
+}
+
+bool StorageBufferObject::CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation){
+	for(int i=0; i<Copies(); ++i){
+		if(allocationsFlying[i] != srcAllocation){
+			continue;
+		}
+		relocatedBuffersFlying[i] = devices->CmdRelocateBuffer(commandBuffer, buffersFlying[i], BufferSize(), usage, dstAllocation);
+		return relocatedBuffersFlying[i] != VK_NULL_HANDLE;
+	}
+	return false;
+}
+void StorageBufferObject::FinishRelocation(VmaAllocation srcAllocation){
+	for(int i=0; i<Copies(); ++i){
+		if(allocationsFlying[i] != srcAllocation){
+			continue;
+		}
+		vkDestroyBuffer(devices->GetLogicalDevice(), buffersFlying[i], nullptr);
+		buffersFlying[i] = relocatedBuffersFlying[i];
+		relocatedBuffersFlying[i] = VK_NULL_HANDLE;
+		// the mapped pointer (if any) moves with the allocation
+		vmaGetAllocationInfo(devices->GetAllocator(), allocationsFlying[i], &(allocationInfosFlying[i]));
+		IncrementHandleVersion();
+		return;
 	}
 }
 
 bool StorageBufferObject::Fill(const std::byte *data){
-	for(int i=0; i<MAX_FRAMES_IN_FLIGHT; ++i){
-		devices->FillExistingDeviceLocalBuffer(buffersFlying[i], {{(void *)(data), size}});
+	return Fill([&](std::span<std::byte> dst){
+		memcpy(dst.data(), data, dst.size());
+	});
+}
+bool StorageBufferObject::Fill(const Devices::MemoryWriter &writer){
+	if(importedMemory){
+		std::cout << "Cannot fill storage buffer; it is imported host memory, which should be written directly.\n";
+		return false;
+	}
+	// the producer writes once; any other flights' copies are copied from the first on the GPU
+	devices->FillExistingDeviceLocalBuffer(buffersFlying[0], allocationsFlying[0], size, writer);
+	if(replication == FlightReplication::PACKED){
+		for(int i=1; i<MAX_FRAMES_IN_FLIGHT; ++i){
+			devices->CopyBuffer(buffersFlying[0], buffersFlying[0], size, 0, i * flightStride);
+		}
+	}
+	for(int i=1; i<Copies(); ++i){
+		devices->CopyBuffer(buffersFlying[0], buffersFlying[i], size);
 	}
 	return true;
 }
 
+TransientRingBuffer::TransientRingBuffer(std::shared_ptr<Devices> _devices,
+										 VkDeviceSize sizePerFlight,
+										 VkBufferUsageFlags usages)
+: devices(std::move(_devices)) {
+	const VkPhysicalDeviceLimits &limits = devices->GetPhysicalDeviceProperties().limits;
+	uniformAlignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+	storageAlignment = std::max<VkDeviceSize>(limits.minStorageBufferOffsetAlignment, 1);
+	
+	// keeping each partition's start aligned for every kind of allocation
+	const VkDeviceSize partitionAlignment = std::max({uniformAlignment, storageAlignment, VkDeviceSize(16)});
+	partitionSize = (sizePerFlight + partitionAlignment - 1) / partitionAlignment * partitionAlignment;
+	
+	devices->CreateBuffer(partitionSize * MAX_FRAMES_IN_FLIGHT,
+						  usages,
+						  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+						  buffer,
+						  allocation,
+						  &allocationInfo,
+						  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+std::optional<TransientRingBuffer::Allocation> TransientRingBuffer::Allocate(VkDeviceSize size, VkDeviceSize alignment){
+	const VkDeviceSize partitionStart = partitionSize * currentFlight;
+	const VkDeviceSize start = (partitionStart + head + alignment - 1) / alignment * alignment;
+	if(start + size > partitionStart + partitionSize){
+		std::cout << "Transient ring buffer partition is full.\n";
+		return {};
+	}
+	head = start + size - partitionStart;
+	return Allocation{
+		.data = static_cast<uint8_t *>(allocationInfo.pMappedData) + start,
+		.offset = start,
+		.size = size
+	};
+}
+
 TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const PNGImageBlueprint &fromPNG)
 : devices(std::move(_devices)){
 	SDL_Surface *const surface = IMG_Load(fromPNG.imageFilename.c_str());
@@ -99,7 +274,8 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const PNGImageBlue
 		.height = uint32_t(surface->h),
 		.pitch = uint32_t(surface->pitch),
 		.format = VK_FORMAT_R8G8B8A8_SRGB,
-		.mip = true
+		.mip = true,
+		.streamed = fromPNG.streamed
 	});
 	//SDLPixelFormatToVulkanFormat((SDL_PixelFormatEnum)devices->surface->format->format); // 24 bit-depth images don't seem to work
 	
@@ -109,6 +285,10 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const DataImageBlu
 : devices(std::move(_devices)) {
 	ConstructFromData(fromRaw);
 }
+TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const GeneratedImageBlueprint &generated)
+: devices(std::move(_devices)) {
+	ConstructGenerated(generated);
+}
 TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const Data3DImageBlueprint &fromRaw3D)
 : devices(std::move(_devices)) {
 	const VkDeviceSize imageSize = fromRaw3D.height * fromRaw3D.pitch * fromRaw3D.depth;
@@ -133,11 +313,11 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const Data3DImageB
 		.format = fromRaw3D.format,
 		.tiling = VK_IMAGE_TILING_OPTIMAL, // VK_IMAGE_TILING_LINEAR for row-major order if we want to access texels in the memory of the image
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-		.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
 	};
-	devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation);
+	devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation, false);
 	
 	const VkImageSubresourceRange subresourceRange = {
 		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -152,7 +332,7 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const Data3DImageB
 	vmaDestroyBuffer(devices->GetAllocator(), stagingBuffer, stagingAllocation);
 	
 	// Creating an image view for the texture image
-	view = devices->CreateImageView({
+	const VkImageViewCreateInfo imageViewCI = {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
@@ -161,10 +341,13 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const Data3DImageB
 		.format = fromRaw3D.format,
 		.components = {},
 		.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
-	});
+	};
+	view = devices->CreateImageView(imageViewCI);
 	
 	extent = imageCI.extent;
 	format = imageCI.format;
+	mipLevels = 1;
+	MakeRelocatable(imageCI, imageViewCI, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 }
 TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const CubemapPNGImageBlueprint &fromPNGCubemaps)
 : devices(std::move(_devices)) {
@@ -209,12 +392,12 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const CubemapPNGIm
 		.format = imageFormat,
 		.tiling = VK_IMAGE_TILING_OPTIMAL,
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-		.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
 		.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
 	};
-	devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation);
+	devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation, false);
 	
 	VkCommandBuffer commandBuffer = devices->BeginSingleTimeCommands();
 	
@@ -249,7 +432,7 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const CubemapPNGIm
 	vmaDestroyBuffer(devices->GetAllocator(), stagingBuffer, stagingAllocation);
 	
 	// Creating an image view for the texture image
-	view = devices->CreateImageView({
+	const VkImageViewCreateInfo imageViewCI = {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
@@ -258,10 +441,13 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const CubemapPNGIm
 		.format = imageFormat,
 		.components = {},
 		.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 6}
-	});
+	};
+	view = devices->CreateImageView(imageViewCI);
 	
 	extent = imageCI.extent;
 	format = imageCI.format;
+	mipLevels = 1;
+	MakeRelocatable(imageCI, imageViewCI, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const ManualImageBlueprint &fromBlueprint)
 : devices(std::move(_devices)) {
@@ -270,17 +456,34 @@ TextureImage::TextureImage(std::shared_ptr<Devices> _devices, const ManualImageB
 
 
 void TextureImage::ConstructFromData(DataImageBlueprint _blueprint){
+	if(_blueprint.streamed){
+		ConstructStreamed(_blueprint);
+		return;
+	}
+	
+	ConstructGenerated({
+		.width = _blueprint.width,
+		.height = _blueprint.height,
+		.pitch = _blueprint.pitch,
+		.format = _blueprint.format,
+		.mip = _blueprint.mip,
+		.writer = [&](std::span<std::byte> dst){
+			memcpy(dst.data(), _blueprint.data, dst.size());
+		}
+	});
+}
+void TextureImage::ConstructGenerated(const GeneratedImageBlueprint &_blueprint){
 	const VkDeviceSize imageSize = _blueprint.height * _blueprint.pitch;
 	
 	// calculated number of mipmap levels
 	mipLevels = _blueprint.mip ? uint32_t(floor(log2(double(_blueprint.width > _blueprint.height ? _blueprint.width : _blueprint.height)))) + 1 : 1;
 	
-	// creating a staging buffer, copying in the pixels and then freeing the SDL devices->surface and the staging buffer memory allocation
+	// creating a staging buffer and having the producer write the pixels straight into it
 	VkBuffer stagingBuffer;
 	VmaAllocation stagingAllocation;
 	VmaAllocationInfo stagingAllocInfo;
 	devices->CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation, &stagingAllocInfo);
-	memcpy(stagingAllocInfo.pMappedData, _blueprint.data, (size_t)imageSize);
+	_blueprint.writer({static_cast<std::byte *>(stagingAllocInfo.pMappedData), size_t(imageSize)});
 	vmaFlushAllocation(devices->GetAllocator(), stagingAllocation, 0, VK_WHOLE_SIZE);
 	
 	// creating the image
@@ -295,11 +498,11 @@ void TextureImage::ConstructFromData(DataImageBlueprint _blueprint){
 		.format = _blueprint.format,
 		.tiling = VK_IMAGE_TILING_OPTIMAL, // VK_IMAGE_TILING_LINEAR for row-major order if we want to access texels in the memory of the image
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-		.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
 	};
-	devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation);
+	devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation, false);
 	
 	const VkImageSubresourceRange subresourceRange = {
 		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -315,7 +518,7 @@ void TextureImage::ConstructFromData(DataImageBlueprint _blueprint){
 	vmaDestroyBuffer(devices->GetAllocator(), stagingBuffer, stagingAllocation);
 	
 	// Creating an image view for the texture image
-	view = devices->CreateImageView({
+	const VkImageViewCreateInfo imageViewCI = {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
@@ -324,10 +527,205 @@ void TextureImage::ConstructFromData(DataImageBlueprint _blueprint){
 		.format = _blueprint.format,
 		.components = {},
 		.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1}
-	});
+	};
+	view = devices->CreateImageView(imageViewCI);
 	
 	extent = imageCI.extent;
 	format = imageCI.format;
+	MakeRelocatable(imageCI, imageViewCI, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+void TextureImage::ConstructStreamed(DataImageBlueprint _blueprint){
+	static constexpr uint32_t texelSize = 4;
+	switch(_blueprint.format){
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+			break;
+		default:
+			throw std::runtime_error("Streamed textures must have an 8-bit, 4 channel format.");
+	}
+	
+	mipLevels = _blueprint.mip ? uint32_t(floor(log2(double(_blueprint.width > _blueprint.height ? _blueprint.width : _blueprint.height)))) + 1 : 1;
+	format = _blueprint.format;
+	
+	streaming = Streaming{
+		.fullExtent = {_blueprint.width, _blueprint.height},
+		.hostMips = std::vector<std::vector<uint8_t>>(mipLevels),
+		.residentBaseMip = mipLevels
+	};
+	
+	// tightly packing the top level
+	streaming->hostMips[0].resize(_blueprint.width * _blueprint.height * texelSize);
+	for(uint32_t y=0; y<_blueprint.height; ++y){
+		memcpy(streaming->hostMips[0].data() + y * _blueprint.width * texelSize, _blueprint.data + y * _blueprint.pitch, _blueprint.width * texelSize);
+	}
+	
+	// generating the rest of the chain on the cpu with a box filter, as the gpu only ever holds part of it
+	uint32_t width = _blueprint.width;
+	uint32_t height = _blueprint.height;
+	for(uint32_t level=1; level<mipLevels; ++level){
+		const uint32_t newWidth = std::max(width / 2, 1u);
+		const uint32_t newHeight = std::max(height / 2, 1u);
+		const std::vector<uint8_t> &src = streaming->hostMips[level - 1];
+		std::vector<uint8_t> &dst = streaming->hostMips[level];
+		dst.resize(newWidth * newHeight * texelSize);
+		for(uint32_t y=0; y<newHeight; ++y){
+			const uint32_t y0 = std::min(2 * y, height - 1);
+			const uint32_t y1 = std::min(2 * y + 1, height - 1);
+			for(uint32_t x=0; x<newWidth; ++x){
+				const uint32_t x0 = std::min(2 * x, width - 1);
+				const uint32_t x1 = std::min(2 * x + 1, width - 1);
+				for(uint32_t c=0; c<texelSize; ++c){
+					const uint32_t sum = uint32_t(src[(y0 * width + x0) * texelSize + c]) +
+										 uint32_t(src[(y0 * width + x1) * texelSize + c]) +
+										 uint32_t(src[(y1 * width + x0) * texelSize + c]) +
+										 uint32_t(src[(y1 * width + x1) * texelSize + c]);
+					dst[(y * newWidth + x) * texelSize + c] = uint8_t((sum + 2) / 4);
+				}
+			}
+		}
+		width = newWidth;
+		height = newHeight;
+	}
+	
+	// only the smallest level starts resident; a `TextureResidencyManager` streams in the rest
+	if(!SetResidentBaseMip(mipLevels - 1)){
+		throw std::runtime_error("failed to upload streamed texture!");
+	}
+}
+VkDeviceSize TextureImage::ResidentSize() const {
+	VmaAllocationInfo allocationInfo;
+	vmaGetAllocationInfo(devices->GetAllocator(), allocation, &allocationInfo);
+	return allocationInfo.size;
+}
+VkDeviceSize TextureImage::StreamedSize(uint32_t baseMip) const {
+	if(!streaming){
+		return 0;
+	}
+	VkDeviceSize ret = 0;
+	for(uint32_t level=baseMip; level<mipLevels; ++level){
+		ret += streaming->hostMips[level].size();
+	}
+	return ret;
+}
+bool TextureImage::SetResidentBaseMip(uint32_t baseMip){
+	VkCommandBuffer commandBuffer = devices->BeginSingleTimeCommands();
+	const bool ret = CmdSetResidentBaseMip(commandBuffer, baseMip);
+	devices->EndSingleTimeCommands(commandBuffer);
+	return ret;
+}
+bool TextureImage::CmdSetResidentBaseMip(VkCommandBuffer commandBuffer, uint32_t baseMip){
+	if(!streaming){
+		std::cout << "Cannot set resident mips of a texture that isn't streamed.\n";
+		return false;
+	}
+	if(baseMip >= mipLevels){
+		std::cout << "Resident base mip out of range.\n";
+		return false;
+	}
+	if(baseMip == streaming->residentBaseMip){
+		return true;
+	}
+	
+	const uint32_t levelCount = mipLevels - baseMip;
+	const VkExtent3D newExtent = {
+		std::max(streaming->fullExtent.width >> baseMip, 1u),
+		std::max(streaming->fullExtent.height >> baseMip, 1u),
+		1
+	};
+	
+	// staging all the resident levels back to back
+	const VkDeviceSize stagingSize = StreamedSize(baseMip);
+	VkBuffer stagingBuffer;
+	VmaAllocation stagingAllocation;
+	VmaAllocationInfo stagingAllocInfo;
+	devices->CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation, &stagingAllocInfo);
+	std::vector<VkBufferImageCopy> regions(levelCount);
+	VkDeviceSize offset = 0;
+	for(uint32_t i=0; i<levelCount; ++i){
+		const std::vector<uint8_t> &level = streaming->hostMips[baseMip + i];
+		memcpy(static_cast<uint8_t *>(stagingAllocInfo.pMappedData) + offset, level.data(), level.size());
+		regions[i] = {
+			.bufferOffset = offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1},
+			.imageOffset = {0, 0, 0},
+			.imageExtent = {std::max(newExtent.width >> i, 1u), std::max(newExtent.height >> i, 1u), 1}
+		};
+		offset += level.size();
+	}
+	vmaFlushAllocation(devices->GetAllocator(), stagingAllocation, 0, VK_WHOLE_SIZE);
+	
+	const VkImageCreateInfo imageCI = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.extent = newExtent,
+		.mipLevels = levelCount,
+		.arrayLayers = 1,
+		.format = format,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+	};
+	VkImage newImage;
+	VmaAllocation newAllocation;
+	try {
+		devices->CreateImage(imageCI, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newImage, newAllocation, false);
+	} catch(const std::runtime_error &error){
+		// out of memory; keep the currently resident mips
+		vmaDestroyBuffer(devices->GetAllocator(), stagingBuffer, stagingAllocation);
+		if(streaming->residentBaseMip < mipLevels){
+			std::cout << error.what() << "\n";
+			return false;
+		}
+		throw;
+	}
+	
+	const VkImageSubresourceRange subresourceRange = {
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0,
+		.levelCount = levelCount,
+		.baseArrayLayer = 0,
+		.layerCount = 1
+	};
+	devices->CmdTransitionImageLayout(commandBuffer, newImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount, regions.data());
+	devices->CmdTransitionImageLayout(commandBuffer, newImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+	
+	// the staging buffer, and the old image that frames in flight may still be reading, are released once they have finished
+	devices->EnqueueDestruction([allocator = devices->GetAllocator(), buffer = stagingBuffer, allocation = stagingAllocation](){
+		vmaDestroyBuffer(allocator, buffer, allocation);
+	});
+	if(streaming->residentBaseMip < mipLevels){
+		devices->EnqueueDestruction([device = devices->GetLogicalDevice(), allocator = devices->GetAllocator(), image = image, allocation = allocation, view = view](){
+			vkDestroyImageView(device, view, nullptr);
+			vmaDestroyImage(allocator, image, allocation);
+		});
+	}
+	image = newImage;
+	allocation = newAllocation;
+	
+	const VkImageViewCreateInfo imageViewCI = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.image = image,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = format,
+		.components = {},
+		.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1}
+	};
+	view = devices->CreateImageView(imageViewCI);
+	
+	extent = newExtent;
+	streaming->residentBaseMip = baseMip;
+	MakeRelocatable(imageCI, imageViewCI, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	IncrementHandleVersion();
+	return true;
 }
 void TextureImage::ConstructManual(ManualImageBlueprint _blueprint){
 	
@@ -343,10 +741,126 @@ void TextureImage::ConstructManual(ManualImageBlueprint _blueprint){
 		.components = {},
 		.subresourceRange = {_blueprint.aspectFlags, 0, _blueprint.imageCI.mipLevels, 0, _blueprint.imageCI.arrayLayers}
 	});
+	if(_blueprint.mipViews){
+		mipViews.reserve(_blueprint.imageCI.mipLevels);
+		for(uint32_t level=0; level<_blueprint.imageCI.mipLevels; ++level){
+			mipViews.push_back(devices->CreateImageView({
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.image = image,
+				.viewType = _blueprint.imageViewType,
+				.format = _blueprint.imageCI.format,
+				.components = {},
+				.subresourceRange = {_blueprint.aspectFlags, level, 1, 0, _blueprint.imageCI.arrayLayers}
+			}));
+		}
+	}
 	
+	mipLevels = _blueprint.imageCI.mipLevels;
 	extent = _blueprint.imageCI.extent;
 	format = _blueprint.imageCI.format;
 }
+void TextureImage::MakeRelocatable(const VkImageCreateInfo &imageCI, const VkImageViewCreateInfo &imageViewCI, VkImageLayout layout){
+	relocationInfo = RelocationInfo{
+		.imageCI = imageCI,
+		.imageViewCI = imageViewCI,
+		.layout = layout
+	};
+	SetRelocatable(devices->GetAllocator(), allocation);
+}
+
+bool TextureImage::CmdRelocate(VkCommandBuffer commandBuffer, VmaAllocation srcAllocation, VmaAllocation dstAllocation){
+	if(!relocationInfo || allocation != srcAllocation){
+		return false;
+	}
+	VkImage newImage;
+	if(vkCreateImage(devices->GetLogicalDevice(), &relocationInfo->imageCI, nullptr, &newImage) != VK_SUCCESS){
+		return false;
+	}
+	if(vmaBindImageMemory(devices->GetAllocator(), dstAllocation, newImage) != VK_SUCCESS){
+		vkDestroyImage(devices->GetLogicalDevice(), newImage, nullptr);
+		return false;
+	}
+	
+	const VkImageSubresourceRange subresourceRange = {
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0,
+		.levelCount = relocationInfo->imageCI.mipLevels,
+		.baseArrayLayer = 0,
+		.layerCount = relocationInfo->imageCI.arrayLayers
+	};
+	VkImageMemoryBarrier barriers[2] = {{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+		.oldLayout = relocationInfo->layout,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image,
+		.subresourceRange = subresourceRange
+	}, {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = newImage,
+		.subresourceRange = subresourceRange
+	}};
+	vkCmdPipelineBarrier(commandBuffer,
+						 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+						 0, nullptr, 0, nullptr,
+						 2, barriers);
+	
+	std::vector<VkImageCopy> regions(relocationInfo->imageCI.mipLevels);
+	for(uint32_t level=0; level<relocationInfo->imageCI.mipLevels; ++level){
+		const VkImageSubresourceLayers subresource = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipLevel = level,
+			.baseArrayLayer = 0,
+			.layerCount = relocationInfo->imageCI.arrayLayers
+		};
+		regions[level] = {
+			.srcSubresource = subresource,
+			.srcOffset = {0, 0, 0},
+			.dstSubresource = subresource,
+			.dstOffset = {0, 0, 0},
+			.extent = {
+				std::max(extent.width >> level, 1u),
+				std::max(extent.height >> level, 1u),
+				std::max(extent.depth >> level, 1u)
+			}
+		};
+	}
+	vkCmdCopyImage(commandBuffer,
+				   image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				   newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				   uint32_t(regions.size()), regions.data());
+	
+	// the old image is about to be destroyed, so only the new one needs returning to the original layout
+	barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].newLayout = relocationInfo->layout;
+	vkCmdPipelineBarrier(commandBuffer,
+						 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+						 0, nullptr, 0, nullptr,
+						 1, &barriers[1]);
+	
+	relocatedImage = newImage;
+	return true;
+}
+void TextureImage::FinishRelocation(VmaAllocation srcAllocation){
+	vkDestroyImageView(devices->GetLogicalDevice(), view, nullptr);
+	vkDestroyImage(devices->GetLogicalDevice(), image, nullptr);
+	image = *relocatedImage;
+	relocatedImage.reset();
+	relocationInfo->imageViewCI.image = image;
+	view = devices->CreateImageView(relocationInfo->imageViewCI);
+	IncrementHandleVersion();
+}
 
 TextureSampler::TextureSampler(std::shared_ptr<Devices> _devices,
 							   const VkSamplerCreateInfo &samplerCI)
@@ -357,6 +871,74 @@ TextureSampler::TextureSampler(std::shared_ptr<Devices> _devices,
 	}
 }
 
+BindlessTextureTable::BindlessTextureTable(std::shared_ptr<Devices> _devices, uint32_t _capacity, const Slot &_fallback)
+: devices(std::move(_devices)), capacity(_capacity), fallback(_fallback) {
+	if(!fallback.image || !fallback.sampler){
+		throw std::runtime_error("Bindless texture table needs a fallback image and sampler.");
+	}
+	fallback.image->AddHandleVersionCounter(version);
+}
+
+std::optional<uint32_t> BindlessTextureTable::Add(const std::shared_ptr<TextureImage> &image, const std::shared_ptr<TextureSampler> &sampler){
+	if(!image || !sampler){
+		std::cout << "Cannot add texture to bindless table; no image or sampler.\n";
+		return {};
+	}
+	const std::pair<const TextureImage *, const TextureSampler *> key = {image.get(), sampler.get()};
+	if(const auto it = indices.find(key); it != indices.end()){
+		++references[it->second];
+		return it->second;
+	}
+	
+	ReleasePendingFrees();
+	
+	uint32_t index;
+	if(!freeIndices.empty()){
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	} else if(slots.size() < capacity){
+		index = uint32_t(slots.size());
+		slots.push_back(fallback);
+		references.push_back(0);
+	} else {
+		std::cout << "Cannot add texture to bindless table; it is full.\n";
+		return {};
+	}
+	slots[index] = {image, sampler};
+	references[index] = 1;
+	indices[key] = index;
+	// moving the image by the defragmenter changes the table's version too
+	image->AddHandleVersionCounter(version);
+	++*version;
+	return index;
+}
+
+void BindlessTextureTable::Remove(uint32_t index){
+	if(index >= slots.size() || references[index] == 0){
+		std::cout << "Cannot remove texture from bindless table; no such index.\n";
+		return;
+	}
+	if(--references[index] > 0){
+		return;
+	}
+	indices.erase({slots[index].image.get(), slots[index].sampler.get()});
+	// frames in flight may still be sampling the slot, so it is only rewritten and reused once they have finished
+	pendingFrees.push_back({devices->FrameTimeline(), index});
+}
+
+void BindlessTextureTable::ReleasePendingFrees(){
+	const uint64_t timeline = devices->FrameTimeline();
+	std::erase_if(pendingFrees, [&](const PendingFree &pending){
+		if(pending.frame + MAX_FRAMES_IN_FLIGHT > timeline){
+			return false;
+		}
+		slots[pending.index] = fallback;
+		freeIndices.push_back(pending.index);
+		++*version;
+		return true;
+	});
+}
+
 BufferedRenderPass::BufferedRenderPass(std::shared_ptr<Devices> _devices,
 									   const VkRenderPassCreateInfo *const pRenderPassCI)
 : devices(std::move(_devices)) {
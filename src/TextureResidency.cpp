@@ -0,0 +1,124 @@
+#include <vma/vk_mem_alloc.h>
+
+#include <algorithm>
+
+#include <TextureResidency.hpp>
+
+namespace EVK {
+
+TextureResidencyManager::TextureResidencyManager(std::shared_ptr<Devices> _devices, const Settings &_settings)
+: devices(std::move(_devices)), settings(_settings) {}
+
+bool TextureResidencyManager::Add(const std::shared_ptr<TextureImage> &texture){
+	if(!texture->Streamed()){
+		std::cout << "Only streamed textures can be managed for residency.\n";
+		return false;
+	}
+	entries[texture.get()] = Entry{
+		.texture = texture,
+		.lastUsedFrame = frame
+	};
+	return true;
+}
+void TextureResidencyManager::Remove(const std::shared_ptr<TextureImage> &texture){
+	entries.erase(texture.get());
+}
+
+void TextureResidencyManager::MarkUsed(const std::shared_ptr<TextureImage> &texture){
+	if(const auto it = entries.find(texture.get()); it != entries.end()){
+		it->second.lastUsedFrame = frame;
+	}
+}
+
+VkDeviceSize TextureResidencyManager::Budget() const {
+	const VkPhysicalDeviceMemoryProperties *memoryProperties;
+	vmaGetMemoryProperties(devices->GetAllocator(), &memoryProperties);
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetHeapBudgets(devices->GetAllocator(), budgets);
+	
+	VkDeviceSize ret = 0;
+	for(uint32_t i=0; i<memoryProperties->memoryHeapCount; ++i){
+		if(memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT){
+			ret += budgets[i].budget;
+		}
+	}
+	return VkDeviceSize(double(ret) * double(settings.budgetFraction));
+}
+VkDeviceSize TextureResidencyManager::ResidentSize() const {
+	VkDeviceSize ret = 0;
+	for(const auto &[key, entry] : entries){
+		ret += entry.texture->ResidentSize();
+	}
+	return ret;
+}
+
+void TextureResidencyManager::Update(VkCommandBuffer commandBuffer){
+	const VkDeviceSize budget = Budget();
+	VkDeviceSize resident = ResidentSize();
+	
+	// least recently used first
+	std::vector<Entry *> order {};
+	order.reserve(entries.size());
+	for(auto &[key, entry] : entries){
+		order.push_back(&entry);
+	}
+	std::sort(order.begin(), order.end(), [](const Entry *a, const Entry *b){ return a->lastUsedFrame < b->lastUsedFrame; });
+	
+	// evicting top mips until within budget, draining the least recently used textures down to their tails one at a time; textures used last frame only lose mips once no others can
+	bool evicted = false;
+	const auto evict = [&](bool includeUsed){
+		for(Entry *entry : order){
+			if(resident <= budget){
+				return;
+			}
+			if(!includeUsed && entry->lastUsedFrame >= frame){
+				continue;
+			}
+			TextureImage &texture = *entry->texture;
+			// dropping as many levels as are needed at once, so the image is only recreated once
+			uint32_t baseMip = texture.ResidentBaseMip();
+			VkDeviceSize freed = 0;
+			while(baseMip < MaxBaseMip(texture) && resident - freed > budget){
+				freed += texture.StreamedSize(baseMip) - texture.StreamedSize(baseMip + 1);
+				++baseMip;
+			}
+			if(baseMip == texture.ResidentBaseMip()){
+				continue;
+			}
+			const VkDeviceSize before = texture.ResidentSize();
+			if(texture.CmdSetResidentBaseMip(commandBuffer, baseMip)){
+				resident = resident - before + texture.ResidentSize();
+				evicted = true;
+			}
+		}
+	};
+	evict(false);
+	evict(true);
+	
+	// refining textures used last frame one level at a time, most recently used first, while the extra memory fits
+	// nothing is refined while evicting, so textures don't alternate between the two
+	uint32_t uploads = 0;
+	for(auto it = order.rbegin(); it != order.rend() && !evicted && uploads < settings.maxUploadsPerUpdate; ++it){
+		Entry *const entry = *it;
+		if(entry->lastUsedFrame < frame){
+			break;
+		}
+		TextureImage &texture = *entry->texture;
+		if(texture.ResidentBaseMip() == 0){
+			continue;
+		}
+		const VkDeviceSize extra = texture.StreamedSize(texture.ResidentBaseMip() - 1) - texture.StreamedSize(texture.ResidentBaseMip());
+		if(resident + extra > budget){
+			continue;
+		}
+		const VkDeviceSize before = texture.ResidentSize();
+		if(texture.CmdSetResidentBaseMip(commandBuffer, texture.ResidentBaseMip() - 1)){
+			resident = resident - before + texture.ResidentSize();
+			++uploads;
+		}
+	}
+	
+	++frame;
+}
+
+} // namespace EVK
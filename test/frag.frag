@@ -4,6 +4,10 @@ layout(set = 0, binding = 0) uniform UBO {
 	float redOffset;
 } ubo;
 
+layout(set = 1, binding = 0) uniform Tint {
+	float greenOffset;
+} tint;
+
 layout(location = 0) in vec3 v_colour;
 
 layout(location = 0) out vec4 outColor;
@@ -11,5 +15,6 @@ layout(location = 0) out vec4 outColor;
 void main() {
 	vec3 colour = v_colour;
 	colour.r += ubo.redOffset;
+	colour.g += tint.greenOffset;
 	outColor = vec4(colour, 1.0);
 }
@@ -5,9 +5,34 @@
 
 #include <SDL2/SDL_vulkan.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <span>
+
 #include "ShaderProgram.hpp"
 #include "Interface.hpp"
 
+// Every heap allocation is counted while `countingAllocations`, to check that a steady-state frame makes none
+static std::atomic<bool> countingAllocations = false;
+static std::atomic<size_t> allocationCount = 0;
+
+void *operator new(std::size_t size){
+	if(countingAllocations){
+		++allocationCount;
+	}
+	if(void *ret = std::malloc(size == 0 ? 1 : size)){
+		return ret;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
 struct Vertex {
 	vec<2, float32_t> position;
 	vec<3, float32_t> colour;
@@ -69,8 +94,14 @@ struct UBO {
 	float redOffset;
 };
 
+// written to a transient ring buffer for each draw, and selected with a dynamic offset number
+struct Tint {
+	float greenOffset;
+};
+
 using type = EVK::Shader<VK_SHADER_STAGE_FRAGMENT_BIT, fragmentFilename, EVK::NoPushConstants
 , EVK::UBOUniform<0, 0, UBO>
+, EVK::RingUBOUniform<1, 0, Tint>
 //,
 //EVK::TextureSamplersUniform<0, 1, 1>,
 //EVK::TextureImagesUniform<0, 2, PNGS_N>,
@@ -274,12 +305,25 @@ int main(int argc, char *argv[]){
 	
 	mainInstancedPipeline->iDescriptorSet<0>().template iDescriptor<0>().Set(ubo);
 	
+	std::shared_ptr<EVK::TransientRingBuffer> ring = std::make_shared<EVK::TransientRingBuffer>(devices, 4096, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+	
+	mainInstancedPipeline->iDescriptorSet<1>().template iDescriptor<0>().Set(ring);
+	
 	const std::function<void(float, uint32_t)> updateFunction = [&](float timeS, uint32_t flight) {
 		ubo->GetDataPointer(flight)->redOffset = 2.0f * sin(timeS);
 	};
 	
 	int time = SDL_GetTicks();
 	
+	// once every flight has recorded a few frames, recording more should need no allocations; only frames that were actually recorded count
+	constexpr int warmUpFrames = 4 * MAX_FRAMES_IN_FLIGHT;
+	constexpr int checkedFrames = 4 * MAX_FRAMES_IN_FLIGHT;
+	int recordedFrames = 0;
+	size_t checkedAllocationCount = 0;
+	
+	// one draw binds the tint with a `dynamicOffsetNumbers_t`, the other with a `std::span` over this
+	std::array<uint32_t, 1> spanNumbers;
+	
 	while(!ESDL::HandleEvents()){
 		const int newTime = SDL_GetTicks();
 //		const float dT = 0.001f*(float)(newTime - time);
@@ -287,16 +331,41 @@ int main(int argc, char *argv[]){
 		
 		const float timeS = 0.001f * static_cast<float>(time);
 		
+		const bool checkingAllocations = recordedFrames >= warmUpFrames && recordedFrames < warmUpFrames + checkedFrames;
+		if(checkingAllocations){
+			allocationCount = 0;
+			countingAllocations = true;
+		}
+		
 		if(std::optional<EVK::CommandEnvironment> ci = interface->BeginFrame(); ci.has_value()){
 			updateFunction(timeS, ci->flight);
+			ring->BeginFlight(ci->flight);
 			
 			interface->BeginSwapChainRenderPass({{0.01f, 0.01f, 0.01f, 1.0f}});
 			
 			mainInstancedPipeline->CmdBind(ci.value());
-			if(mainInstancedPipeline->CmdBindDescriptorSets<0, 1>(ci.value()) && vbo->CmdBind(ci.value(), 0)){
-				Pipeline::VertexShader::PushConstantType pcs = pcsFunction(timeS);
-				mainInstancedPipeline->CmdPushConstants<0>(ci.value(), &pcs);
-				vkCmdDraw(ci.value(), 3, 1, 0, 0);
+			if(mainInstancedPipeline->CmdBindDescriptorSets<0, 1>(ci.value(), Pipeline::type::dynamicOffsetNumbers_t<0, 1>{}) && vbo->CmdBind(ci.value(), 0)){
+				for(int i=0; i<2; ++i){
+					const std::optional<EVK::TransientRingBuffer::Allocation> tint = ring->AllocateUniform(sizeof(Pipeline::FragmentShader::Tint));
+					if(!tint){
+						continue;
+					}
+					static_cast<Pipeline::FragmentShader::Tint *>(tint->data)->greenOffset = i == 0 ? 0.0f : cos(timeS);
+					bool bound;
+					if(i == 0){
+						bound = mainInstancedPipeline->CmdBindDescriptorSets<1, 1>(ci.value(), Pipeline::type::dynamicOffsetNumbers_t<1, 1>{uint32_t(ring->DynamicOffsetNumber(tint.value()))});
+					} else {
+						spanNumbers[0] = uint32_t(ring->DynamicOffsetNumber(tint.value()));
+						bound = mainInstancedPipeline->CmdBindDescriptorSets<1, 1>(ci.value(), std::span<const uint32_t>(spanNumbers));
+					}
+					if(!bound){
+						std::cout << "Failing to draw.\n";
+						continue;
+					}
+					Pipeline::VertexShader::PushConstantType pcs = pcsFunction(i == 0 ? timeS : -timeS);
+					mainInstancedPipeline->CmdPushConstants<0>(ci.value(), &pcs);
+					vkCmdDraw(ci.value(), 3, 1, 0, 0);
+				}
 			} else {
 				std::cout << "Failing to draw.\n";
 			}
@@ -304,10 +373,26 @@ int main(int argc, char *argv[]){
 			vkCmdEndRenderPass(ci.value());
 			
 			interface->EndFrame();
+			
+			++recordedFrames;
+			if(checkingAllocations){
+				checkedAllocationCount += allocationCount;
+			}
 		} else {
 			std::cout << "Failed to begin frame.\n";
 		}
 		
+		if(checkingAllocations){
+			countingAllocations = false;
+			if(recordedFrames == warmUpFrames + checkedFrames){
+				if(checkedAllocationCount > 0){
+					std::cout << "Steady-state frames made " << checkedAllocationCount << " heap allocations.\n";
+					SDL_DestroyWindow(window);
+					return EXIT_FAILURE;
+				}
+				std::cout << "Steady-state frames made no heap allocations.\n";
+			}
+		}
 	}
 	
 	std::cout << "Exiting.\n";